@@ -0,0 +1,63 @@
+#ifndef ALLOCATORS_H_
+#define ALLOCATORS_H_
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "common.h"
+#include "memory_tracker.h"
+
+/**
+  * @brief Pool of equally sized blocks carved out of large slabs, blocks are recycled through a free list and slabs are never returned
+*/
+class SlabPool {
+public:
+  SlabPool(size_t _blockSize, uint _blocksPerSlab, MemoryTracker::Tag _tag);
+  ~SlabPool();
+
+  void* allocate();
+  void release(void* block);
+
+  // back new slabs with transparent huge pages where the platform supports it
+  void setHugePages(bool value);
+
+  uint getSlabCount();
+  uint getBlocksInUse();
+
+private:
+  size_t blockSize;
+  uint blocksPerSlab;
+  MemoryTracker::Tag tag;
+  bool hugePages;
+
+  std::mutex mutex;
+  std::vector<void*> slabs;
+  std::vector<size_t> slabSizes;
+  void* freeList;
+  uint blocksInUse;
+
+  void addSlab();
+};
+
+/*
+  linear allocator for data that only lives until the end of the current
+  frame. main thread only, everything is dropped by FrameArena::reset
+*/
+namespace FrameArena {
+
+void* allocate(size_t size);
+void reset();
+void free();
+
+size_t getUsed();
+size_t getCapacity();
+
+template <typename T>
+inline T* allocate(size_t count) {
+  return (T*)allocate(count * sizeof(T));
+}
+
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef ASSET_PACK_H_
+#define ASSET_PACK_H_
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "common.h"
+
+/*
+  every asset in one file, memory mapped read only so lookups hand out
+  pointers straight into the mapping:
+    "CVXA", version, entry count, reserved, count x {name[NAME_LENGTH], offset, size}
+  blobs start ALIGNMENT aligned, offsets are from the start of the file and
+  every number is a little endian uint32. files in the override directory, if
+  one is set, win over the pack so single assets can be swapped without
+  rebuilding it. they are read on every get, so loading an asset again picks
+  up the edited file
+*/
+namespace AssetPack {
+
+const uint VERSION = 1;
+const uint ALIGNMENT = 64;
+const uint NAME_LENGTH = 56;
+
+struct asset_t {
+  const uint8_t* data;
+  size_t size;
+};
+
+using asset_list = std::vector<std::pair<std::string, std::vector<uint8_t>>>;
+
+// overrideDirectory may be nullptr
+bool open(const char* path, const char* overrideDirectory);
+void close();
+
+// data stays valid until close or, for overrides, the next get of the same name
+bool get(const char* name, asset_t* asset);
+
+// used by the tools that build the pack
+bool write(const char* path, const asset_list& assets);
+
+}
+
+#endif
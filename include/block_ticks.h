@@ -0,0 +1,35 @@
+#ifndef BLOCK_TICKS_H_
+#define BLOCK_TICKS_H_
+
+#include "common.h"
+
+/*
+  block behavior on the fixed tick. scheduled ticks wait in a timing wheel
+  and fire after a delay, e.g. sand falling once the block under it is gone.
+  random ticks sample a few blocks per tick from the chunks that hold any
+  random tickable block, e.g. grass spreading. every change goes through
+  World::setBlocks once per tick. main thread only
+*/
+namespace BlockTicks {
+
+void free();
+
+// ticks the block after delay simulation ticks, at most once per block
+void schedule(int x, int y, int z, uint delay);
+
+// a block was edited, schedules it and its neighbors as their type requires
+void blockChanged(int x, int y, int z);
+// a block next to an edit, schedules just it if its type waits for changes around it
+void neighborChanged(int x, int y, int z);
+// a chunk was loaded or bulk edited, bulk edits also pass the blocks along the edit to neighborChanged
+void chunkChanged(vec3i pos);
+
+// call once per simulation tick
+void tick();
+
+// ticks waiting in the wheel
+uint getScheduledCount();
+
+}
+
+#endif
@@ -15,7 +15,11 @@ enum BlockType : block_t {
   GLASS,
   SNOW,
   WATER,
-  LOG
+  LOG,
+  LEAVES,
+  LAMP,
+  // first of the flowing water blocks, one id per level 1 to MAX_WATER_LEVEL
+  FLOWING_WATER
 };
 
 const int BLOCKS[256][6] = {
@@ -30,6 +34,60 @@ const int BLOCKS[256][6] = {
   {6, 6, 6, 6, 6, 6}, // 7 - snow
   {7, 7, 7, 7, 7, 7}, // 8 - water
   {9, 9, 10, 10, 9, 9}, // 9 - log
+  {8, 8, 8, 8, 8, 8}, // 10 - leaves (grass top until they get a texture)
+  {6, 6, 6, 6, 6, 6}, // 11 - lamp (snow until it gets a texture)
+  {7, 7, 7, 7, 7, 7}, // 12 - flowing water 1
+  {7, 7, 7, 7, 7, 7}, // 13 - flowing water 2
+  {7, 7, 7, 7, 7, 7}, // 14 - flowing water 3
+  {7, 7, 7, 7, 7, 7}, // 15 - flowing water 4
+  {7, 7, 7, 7, 7, 7}, // 16 - flowing water 5
+  {7, 7, 7, 7, 7, 7}, // 17 - flowing water 6
+  {7, 7, 7, 7, 7, 7}, // 18 - flowing water 7
 };
 
+// water blocks are a level away from their source, WATER itself is the source at 0
+const uint8_t MAX_WATER_LEVEL = 7;
+
+// ids past the last flowing water block are unused
+const uint32_t BLOCK_COUNT = FLOWING_WATER + MAX_WATER_LEVEL;
+
+// for ids that come from outside, e.g. the network
+inline bool isValidBlock(uint32_t id) {
+  return id < BLOCK_COUNT;
+}
+
+inline bool isWater(block_t block) {
+  return block == WATER || (block >= FLOWING_WATER && block < FLOWING_WATER + MAX_WATER_LEVEL);
+}
+
+inline uint8_t getWaterLevel(block_t block) {
+  return block == WATER ? 0 : block - FLOWING_WATER + 1;
+}
+
+inline block_t getWaterBlock(uint8_t level) {
+  return level == 0 ? WATER : (block_t)(FLOWING_WATER + level - 1);
+}
+
+// light levels run from 0 to 15
+const uint8_t MAX_LIGHT = 15;
+
+// light spreads through these, losing a level per block
+inline bool isLightTransparent(block_t block) {
+  return block == AIR || block == GLASS || block == LEAVES || isWater(block);
+}
+
+// full sunlight falls straight down through these without dimming
+inline bool isSunTransparent(block_t block) {
+  return block == AIR || block == GLASS;
+}
+
+// blocks that act on their own now and then, picked by random block ticks
+inline bool isRandomTickable(block_t block) {
+  return block == GRASS;
+}
+
+inline uint8_t getBlockEmission(block_t block) {
+  return block == LAMP ? MAX_LIGHT : 0;
+}
+
 #endif
@@ -28,7 +28,7 @@ public:
 
   Camera(glm::vec3 _position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 _up = glm::vec3(0.0f, 1.0f, 0.0f), float _yaw = YAW, float _pitch = PITCH) : front(glm::vec3(0.0f, 0.0f, -1.0f)), fov(FOV),
     fast(false), movementSpeed(SPEED), mouseSensitivity(SENSITIVITY) {
-    position = _position;
+    position = previousPosition = _position;
     worldUp = _up;
     yaw = _yaw;
     pitch = pitch;
@@ -36,7 +36,7 @@ public:
   }
   Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float _yaw, float _pitch) : front(glm::vec3(0.0f, 0.0f, -1.0f)), fov(FOV), fast(false), movementSpeed(SPEED),
     mouseSensitivity(SENSITIVITY) {
-    position = glm::vec3(posX, posY, posZ);
+    position = previousPosition = glm::vec3(posX, posY, posZ);
     worldUp = glm::vec3(upX, upY, upZ);
     yaw = _yaw;
     pitch = pitch;
@@ -47,11 +47,23 @@ public:
     return glm::lookAt(position, position + front, up);
   }
 
+  // between the last two simulation ticks, alpha 0 is the previous tick and 1 the latest
+  glm::mat4 getViewMatrix(float alpha) {
+    glm::vec3 eye = previousPosition + (position - previousPosition) * alpha;
+    return glm::lookAt(eye, eye + front, up);
+  }
+
+  // call at the start of every simulation tick, before moving
+  void beginTick() {
+    previousPosition = position;
+  }
+
   void processKeyboard(CameraMovement direction, float deltaTime);
   void processMouseMovement(float xoffset, float yoffset, bool constrainPitch = true);
   void processMouseScroll(float yoffset);
 
 private:
+  glm::vec3 previousPosition;
   glm::vec3 up;
   glm::vec3 right;
   glm::vec3 worldUp;
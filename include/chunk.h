@@ -6,14 +6,10 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
-#include "gl/vao.h"
-
 #include "common.h"
+#include "allocators.h"
 #include "blocks.h"
-
-#define CHUNK_SIZE 32
-#define CHUNK_SIZE_SQUARED 1024
-#define CHUNK_SIZE_CUBED 32768
+#include "chunk_data.h"
 
 typedef int vec2i[2];
 
@@ -25,26 +21,77 @@ public:
   uint elements;
   bool changed;
   bool empty;
+  // bit per region that holds any non air block, see regionBit
+  uint64_t occupancy;
   glm::mat4 model;
 
-  Chunk(int _x, int _y, int _z);
+  // set once the lighting worker first lit the chunk, it isn't meshed before
+  bool lit;
+  // set by the lighting worker while it lights the chunk from scratch, with Lighting::mutex held
+  bool seeding;
+  // blocks for which isRandomTickable holds, kept up to date by set and blocksChanged
+  uint tickableCount;
+
+  // block storage for every chunk, 64 chunks per 2MB slab
+  static SlabPool blockPool;
+  // light storage, a byte per block
+  static SlabPool lightPool;
+
+  Chunk(int _x, int _y, int _z, block_t* _blocks, uint64_t _occupancy);
   ~Chunk();
 
+  // remeshes into a frame arena buffer if the chunk changed, true if a mesh was built
   bool update();
-  void draw();
 
-  block_t get(uint8_t _x, uint8_t _y, uint8_t _z, const std::shared_ptr<Chunk>& px, const std::shared_ptr<Chunk>& nx, const std::shared_ptr<Chunk>& py, const std::shared_ptr<Chunk>& ny,
+  // true from update until the renderer took the mesh, which must happen in the same frame
+  bool hasNewMesh() const {
+    return meshChanged;
+  }
+
+  // elements vertices of two ints, the packed vertex and the light in front of its face. nullptr for an empty mesh
+  const int* getMesh() const {
+    return vertexData;
+  }
+
+  void meshTaken() {
+    vertexData = nullptr;
+    meshChanged = false;
+  }
+
+  block_t get(int _x, int _y, int _z, const std::shared_ptr<Chunk>& px, const std::shared_ptr<Chunk>& nx, const std::shared_ptr<Chunk>& py, const std::shared_ptr<Chunk>& ny,
               const std::shared_ptr<Chunk>& pz, const std::shared_ptr<Chunk>& nz);
+  uint8_t getLight(int _x, int _y, int _z, const std::shared_ptr<Chunk>& px, const std::shared_ptr<Chunk>& nx, const std::shared_ptr<Chunk>& py, const std::shared_ptr<Chunk>& ny,
+                   const std::shared_ptr<Chunk>& pz, const std::shared_ptr<Chunk>& nz);
   block_t get(uint8_t _x, uint8_t _y, uint8_t _z);
   void set(uint8_t _x, uint8_t _y, uint8_t _z, block_t block);
 
+  // raw storage for bulk edits, indexed with blockIndex. call blocksChanged once done
+  block_t* getBlocks() {
+    return blocks;
+  }
+
+  void blocksChanged();
+
+  // sun << 4 | block light per block, indexed with blockIndex. written by the lighting worker with Lighting::mutex held
+  uint8_t* getLight() {
+    return light;
+  }
+
+  bool isRegionEmpty(uint8_t _x, uint8_t _y, uint8_t _z) const {
+    return (occupancy & (1ull << regionBit(_x, _y, _z))) == 0;
+  }
+
 private:
   block_t* blocks;
-  GL::VAO* vao;
+  uint8_t* light;
   bool meshChanged;
-  std::vector<int> vertexData;
+  // lives in the FrameArena, must be buffered in the same frame it was built
+  int* vertexData;
 
-  inline void bufferMesh();
+  inline Chunk* neighborAt(int _x, int _y, int _z, const std::shared_ptr<Chunk>& px, const std::shared_ptr<Chunk>& nx, const std::shared_ptr<Chunk>& py, const std::shared_ptr<Chunk>& ny,
+                           const std::shared_ptr<Chunk>& pz, const std::shared_ptr<Chunk>& nz);
+  void updateRegion(uint8_t _x, uint8_t _y, uint8_t _z);
+  void countTickable();
 };
 
 #endif
@@ -0,0 +1,51 @@
+#ifndef CHUNK_DATA_H_
+#define CHUNK_DATA_H_
+
+#include "common.h"
+#include "blocks.h"
+
+// chunk dimensions and block storage layout, free of any renderer code
+
+#define CHUNK_SIZE 32
+#define CHUNK_SIZE_SQUARED 1024
+#define CHUNK_SIZE_CUBED 32768
+
+// chunks are split into 4x4x4 regions of 8^3 blocks, one occupancy bit each
+#define CHUNK_REGION_SIZE 8
+#define CHUNK_REGIONS_PER_AXIS 4
+
+// worst case mesh is a chunk full of transparent blocks like glass, every block with all 6 faces of 6 vertices
+#define MAX_CHUNK_VERTICES (CHUNK_SIZE_CUBED * 6 * 6)
+
+// floor division, world block coordinate to chunk coordinate (also for negative blocks)
+inline int toChunkCoord(int v) {
+  return (v < 0 ? v - (CHUNK_SIZE - 1) : v) / CHUNK_SIZE;
+}
+
+// world block coordinate to the block inside its chunk
+inline uint8_t toLocalCoord(int v) {
+  return (uint8_t)(v - toChunkCoord(v) * CHUNK_SIZE);
+}
+
+inline ushort blockIndex(uint8_t x, uint8_t y, uint8_t z) {
+  return x | (y << 5) | (z << 10);
+}
+
+inline uint regionBit(uint8_t _x, uint8_t _y, uint8_t _z) {
+  return (_x / CHUNK_REGION_SIZE) | ((_y / CHUNK_REGION_SIZE) << 2) | ((_z / CHUNK_REGION_SIZE) << 4);
+}
+
+// bit per region holding any non air block
+inline uint64_t computeOccupancy(const block_t* blocks) {
+  uint64_t occupancy = 0;
+
+  for(uint i = 0; i < CHUNK_SIZE_CUBED; i++) {
+    if(blocks[i] != AIR) {
+      occupancy |= 1ull << regionBit(i & (CHUNK_SIZE - 1), (i >> 5) & (CHUNK_SIZE - 1), i >> 10);
+    }
+  }
+
+  return occupancy;
+}
+
+#endif
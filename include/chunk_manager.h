@@ -4,10 +4,7 @@
 #include <map>
 #include <memory>
 
-#include <glm/gtc/matrix_transform.hpp>
-
 #include "common.h"
-#include "gl/shader.h"
 #include "chunk.h"
 
 using chunk_map = std::map<vec3i, std::shared_ptr<Chunk>>;
@@ -16,13 +13,26 @@ using chunk_it = chunk_map::iterator;
 namespace ChunkManager {
 
 extern chunk_map chunks;
-extern GL::Shader* shader;
 
-void init();
+// starts the terrain workers and queues the area around camPos
+void prepare(vec3i camPos);
 void free();
 std::shared_ptr<Chunk> get(vec3i pos);
+// loads chunks around camPos and unloads those out of range, meshing is left to the renderer
 void update(vec3i camPos);
-void draw(glm::mat4 projection, glm::mat4 view);
+
+/*
+  applies a new view distance at runtime. growing only queues the new shells,
+  shrinking drops pending work outside and lets update unload within its budget
+*/
+void setViewDistance(int distance);
+int getViewDistance();
+
+// chebyshev radius around the camera chunk that is fully loaded, the fog follows it
+int getLoadedRadius();
+
+// the chunk position passed to the last update
+vec3i getCameraChunk();
 
 }
 
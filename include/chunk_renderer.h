@@ -0,0 +1,31 @@
+#ifndef CHUNK_RENDERER_H_
+#define CHUNK_RENDERER_H_
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "gl/shader.h"
+
+#include "common.h"
+
+/*
+  draws the chunks loaded by ChunkManager. meshes the visible chunks that
+  changed within the per-frame budget and keeps their gpu buffers keyed by
+  position, buffers of unloaded chunks are dropped on the next draw
+*/
+namespace ChunkRenderer {
+
+extern GL::Shader* shader;
+
+// after ChunkManager::prepare, needs a gl context
+void init();
+void free();
+// builds the shader again from the asset pack, picking up edited override files
+void reloadShader();
+void draw(glm::mat4 projection, glm::mat4 view);
+
+// every chunk within the view distance is loaded and the visible ones were lit and meshed by the last draw
+bool isViewComplete();
+
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef CHUNK_STREAM_H_
+#define CHUNK_STREAM_H_
+
+#include <vector>
+
+#include "common.h"
+#include "allocators.h"
+#include "terrain.h"
+#include "world.h"
+
+/*
+  client side of the world server, see tools/server.cpp. while connected the
+  chunk manager requests chunks from the server instead of generating them,
+  and edits are exchanged as single block deltas. main thread only
+*/
+namespace ChunkStream {
+
+// waits for the server's hello, false if it can't be reached or speaks another protocol
+bool connect(const char* address);
+void disconnect();
+bool isConnected();
+// the server's world seed, valid once connected
+uint getSeed();
+
+void request(vec3i pos);
+// the server forgets requests and deltas further than distance chunks from center, and generates only inside it
+void prune(vec3i center, int distance);
+// tells the server about an edit made here
+void sendEdit(int x, int y, int z, block_t block);
+
+// sends and receives what the socket allows, moves up to max received chunks into out. blocks are allocated from pool
+uint collect(std::vector<Terrain::generated_chunk_t>& out, uint max, SlabPool* blockPool);
+// edits other clients made since the last call
+void collectDeltas(std::vector<World::block_edit_t>& out);
+
+}
+
+#endif
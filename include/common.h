@@ -18,11 +18,45 @@ typedef uint16_t ushort;
 #define CATCH_OPENGL_ERROR
 #endif
 
-extern std::string stackTraceName;
-extern std::string stackTraceFile;
-extern uint stackTraceLine;
-extern std::string stackTraceFunc;
-void stackTracePush(const char* name, const char* file, uint line, const char* func);
+// crash breadcrumbs, each thread keeps the last BREADCRUMB_COUNT pushes in its own ring
+const uint BREADCRUMB_COUNT = 16; // must be a power of two
+const uint BREADCRUMB_MAX_THREADS = 32;
+
+struct breadcrumb_t {
+  const char* name;
+  const char* file;
+  const char* func;
+  uint line;
+};
+
+struct breadcrumb_ring_t {
+  breadcrumb_t crumbs[BREADCRUMB_COUNT];
+  uint head;
+};
+
+extern thread_local breadcrumb_ring_t* threadBreadcrumbs;
+breadcrumb_ring_t* registerBreadcrumbThread();
+
+// only plain stores into static memory, cheap enough for hot loops
+inline void stackTracePush(const char* name, const char* file, uint line, const char* func) {
+  breadcrumb_ring_t* ring = threadBreadcrumbs != nullptr ? threadBreadcrumbs : registerBreadcrumbThread();
+
+  if(ring == nullptr) {
+    return;
+  }
+
+  breadcrumb_t& crumb = ring->crumbs[ring->head & (BREADCRUMB_COUNT - 1)];
+  crumb.name = name;
+  crumb.file = file;
+  crumb.func = func;
+  crumb.line = line;
+  ring->head++;
+}
+
+// async-signal-safe output helpers, usable from signal handlers
+void writeSignalSafe(int fd, const char* str);
+void writeSignalSafe(int fd, long value);
+void dumpBreadcrumbs(int fd);
 
 #define STACK_TRACE_PUSH(x) stackTracePush(x, __FILE__, __LINE__, __func__);
 
@@ -105,5 +139,6 @@ const static int8_t cube_vertices[] = {
 extern int viewDistance;
 extern int maxChunksGeneratedPerFrame;
 extern int maxChunksDeletedPerFrame;
+extern bool hugePages;
 
 #endif
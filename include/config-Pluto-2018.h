@@ -1,16 +1,34 @@
 #ifndef CONFIG_H_
 #define CONFIG_H_
 
+#include <map>
+#include <string>
+
+/*
+  key=value file parsed once into a map. poll picks up edits to the file
+  (inotify on linux, modification time elsewhere) and reparses it
+*/
 class Config {
 public:
   Config(const char* configPath);
+  ~Config();
 
-  char* getString(const char* varName);
+  // valid until the next reload, NULL if the key is missing
+  const char* getString(const char* varName);
   int getInt(const char* varName, int defaultValue);
   bool getBool(const char* varName, bool defaultValue);
 
+  bool reload();
+  // cheap enough to call every frame, returns true if the file changed and was reloaded
+  bool poll();
+
 private:
   const char* path;
+  std::map<std::string, std::string> values;
+
+  int watchFd;
+  long lastModified;
+  double lastCheck;
 };
 
 #endif
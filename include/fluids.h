@@ -0,0 +1,27 @@
+#ifndef FLUIDS_H_
+#define FLUIDS_H_
+
+#include "common.h"
+
+/*
+  flowing water as a cellular simulation on the fixed tick. only cells that
+  changed, or sit next to a change, are looked at in the next step, kept per
+  chunk as block indices. terrain water stays still until something next to
+  it is edited. main thread only
+*/
+namespace Fluids {
+
+void free();
+
+// looks at the block and its six neighbors in the next step, call after editing it
+void activate(int x, int y, int z);
+
+// call once per simulation tick, water moves every few ticks
+void tick();
+
+// cells waiting for the next step
+uint getActiveCount();
+
+}
+
+#endif
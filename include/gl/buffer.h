@@ -12,6 +12,12 @@ enum BufferType {
   ELEMENT_ARRAY = GL_ELEMENT_ARRAY_BUFFER
 };
 
+enum BufferUsage {
+  STATIC_DRAW = GL_STATIC_DRAW,
+  DYNAMIC_DRAW = GL_DYNAMIC_DRAW,
+  STREAM_DRAW = GL_STREAM_DRAW
+};
+
 template <BufferType T>
 class Buffer {
 public:
@@ -21,6 +27,12 @@ public:
   void bind();
   static void unbind();
   void data(size_t size, const void* data);
+  void data(size_t size, const void* data, BufferUsage usage);
+  void subData(size_t offset, size_t size, const void* data);
+
+  uint getHandle() const {
+    return handle;
+  }
 
 private:
   uint handle;
@@ -1,25 +1,48 @@
 #ifndef GL_INSTANCE_BUFFER_H_
 #define GL_INSTANCE_BUFFER_H_
 
+#include <vector>
+#include <initializer_list>
+
 #include "gl/vao.h"
 
 #include "common.h"
 
 namespace GL {
 
-template <typename T>
+// one per-instance attribute inside an interleaved element
+struct InstanceAttrib {
+  uint index;
+  uint size;
+  DataType type;
+  bool normalized;
+  size_t offset;
+};
+
 class InstanceBuffer {
 public:
-  InstanceBuffer(VAO* vao, int initialSize, uint attrib);
+  InstanceBuffer(VAO* _vao, int initialSize, uint _stride, std::initializer_list<InstanceAttrib> _layout);
   ~InstanceBuffer();
 
   void bind();
   void expand(int newLength);
   void bufferData(int newLength);
+  void subData(int first, int count, const void* data);
+  // gpu side copy of count elements from another buffer, e.g. a StreamBuffer region
+  void copy(uint source, size_t sourceOffset, int first, int count);
+
+  // re-point the attributes so instance 0 reads element first, GL 3.3 has no base instance draws
+  void setBaseInstance(int first);
+
+  int getLength() const {
+    return currentLength;
+  }
 
 private:
+  VAO* vao;
   uint vbo;
-  size_t vertexSize;
+  uint stride;
+  std::vector<InstanceAttrib> layout;
   int currentLength;
 };
 
@@ -5,7 +5,6 @@
 #include <glm/mat4x4.hpp>
 
 #include "gl/utils.h"
-#include "shaders.h"
 
 #include "common.h"
 
@@ -14,6 +13,8 @@ namespace GL {
 class Shader {
 public:
   Shader(ShaderSource source);
+  // loads shaders/<name>/vertex.glsl and fragment.glsl from the asset pack
+  Shader(const char* name);
   ~Shader();
 
   void use();
@@ -31,6 +32,13 @@ public:
     glUniform1i(location, value);
   }
 
+  void setFloat(const char* name, float value) const {
+    glUniform1f(getUniformLocation(name), value);
+  }
+  void setFloat(int location, float value) const {
+    glUniform1f(location, value);
+  }
+
   void setVec3(const char* name, glm::vec3& value) const {
     glUniform3fv(getUniformLocation(name), 1, &value[0]);
   }
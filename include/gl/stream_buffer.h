@@ -0,0 +1,55 @@
+#ifndef GL_STREAM_BUFFER_H_
+#define GL_STREAM_BUFFER_H_
+
+#include "gl/utils.h"
+
+#include "common.h"
+
+namespace GL {
+
+/*
+  ring of regions for data written by the cpu every frame. the current
+  region is sub-allocated with map/commit, endFrame fences it and moves on
+  to the next one, which is only reused once the gpu has passed its fence.
+  uses a persistent coherent mapping when buffer storage is available,
+  otherwise writes go to a cpu copy and commit uploads them with
+  glBufferSubData, which does not stall since the region is already fenced
+*/
+class StreamBuffer {
+public:
+  StreamBuffer(size_t _regionSize, uint _regionCount = 3);
+  ~StreamBuffer();
+
+  // pointer to size bytes in the current region, nullptr if the region is full
+  void* map(size_t size);
+  // makes the last mapped range visible to the gpu, returns its offset in the buffer
+  size_t commit();
+  // call after the last command reading this frame's data
+  void endFrame();
+
+  uint getHandle() const {
+    return handle;
+  }
+
+  bool isPersistent() const {
+    return persistent;
+  }
+
+private:
+  uint handle;
+  size_t regionSize;
+  uint regionCount;
+  bool persistent;
+
+  uint8_t* memory;
+  GLsync* fences;
+
+  uint region;
+  size_t used;
+  size_t mappedOffset;
+  size_t mappedSize;
+};
+
+}
+
+#endif
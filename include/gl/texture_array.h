@@ -1,6 +1,8 @@
 #ifndef GL_TEXTURE_ARRAY_H_
 #define GL_TEXTURE_ARRAY_H_
 
+#include <stddef.h>
+
 #include "gl/utils.h"
 
 #include "common.h"
@@ -9,7 +11,12 @@ namespace GL {
 
 class TextureArray {
 public:
-  TextureArray(uint index, uint textureCount, uint textureRes, uint8_t* loadTexture(int));
+  /*
+    blob is the textures asset written by the embed_images tool: a {count,
+    resolution, levels, reserved} uint32 header, then every mip level from the
+    largest down, each level with all of its layers back to back as RGBA8
+  */
+  TextureArray(uint index, const uint8_t* blob, size_t size);
   ~TextureArray();
 
 private:
@@ -7,9 +7,12 @@
 
 namespace GL {
 
+// sources straight from the asset pack aren't NUL terminated, so they carry their lengths
 struct ShaderSource {
   const char* vertex;
   const char* fragment;
+  int vertexLength;
+  int fragmentLength;
 };
 
 enum DepthTest {
@@ -48,8 +51,7 @@ enum ClearMask : uint {
 };
 
 void init();
-template <typename T> T* mapBuffer();
-void unmapBuffer();
+void copyBuffer(uint source, size_t sourceOffset, uint destination, size_t destinationOffset, size_t size);
 void drawInstanced(uint verticesCount, uint objectCount);
 void drawElements(uint count);
 void drawArrays(uint count);
@@ -9,7 +9,10 @@ namespace GL {
 
 enum DataType {
   BYTE = GL_BYTE,
-  INT = GL_INT
+  UNSIGNED_BYTE = GL_UNSIGNED_BYTE,
+  INT = GL_INT,
+  HALF_FLOAT = GL_HALF_FLOAT,
+  FLOAT = GL_FLOAT
 };
 
 class VAO {
@@ -27,6 +30,9 @@ public:
 
   void attribI(uint index, uint size, DataType type);
 
+  // attribute read from the currently bound array buffer at the given stride and byte offset
+  void attribPointer(uint index, uint size, DataType type, bool normalized, uint stride, size_t offset, uint divisor);
+
 private:
   uint handle;
 };
@@ -113,7 +113,7 @@ enum class MouseButton {
 void init(GLFWwindow* _window);
 void update();
 KeyEvent getKey(Key keycode);
-bool getMosue(MouseButton button);
+KeyEvent getMosue(MouseButton button);
 
 };
 
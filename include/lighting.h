@@ -0,0 +1,38 @@
+#ifndef LIGHTING_H_
+#define LIGHTING_H_
+
+#include <mutex>
+#include <vector>
+
+#include "common.h"
+#include "chunk.h"
+
+/*
+  sunlight and block light, 0-15 each, flood filled across chunk borders by
+  breadth first add and remove queues on a worker thread. edits only touch
+  the volume their light reaches. the worker reads blocks and writes the
+  light arrays with mutex held, so block edits and meshing take it too
+*/
+namespace Lighting {
+
+extern std::mutex mutex;
+
+void init();
+void free();
+
+// the chunk must stay loaded until removeChunk, main thread only
+void addChunk(Chunk* chunk);
+// main thread, before the chunk is destroyed. takes mutex, so not while holding it
+void removeChunk(vec3i pos);
+
+// a single block changed at the world position, call after the edit
+void blockChanged(int x, int y, int z);
+// any block of the chunk may have changed, e.g. after a bulk edit
+void chunkChanged(vec3i pos);
+
+// chunks whose light changed since the last call, their meshes are stale
+void collect(std::vector<vec3i>& out);
+
+}
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef MEMORY_TRACKER_H_
+#define MEMORY_TRACKER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common.h"
+
+#define MEMORY_TAG_CONCAT_INNER(a, b) a##b
+#define MEMORY_TAG_CONCAT(a, b) MEMORY_TAG_CONCAT_INNER(a, b)
+
+// attributes every allocation in the rest of the enclosing block to a subsystem
+#define MEMORY_TAG(x) MemoryTracker::TagScope MEMORY_TAG_CONCAT(memoryTag, __LINE__)(x);
+
+namespace MemoryTracker {
+
+enum Tag : uint8_t {
+  GENERAL = 0,
+  CHUNK_STORAGE,
+  MESHING,
+  PARTICLES,
+  GL_WRAPPERS,
+  TAG_COUNT
+};
+
+// power of two size classes, the last one holds everything bigger
+const uint SIZE_CLASSES = 16;
+
+struct tag_stats_t {
+  uint64_t allocations;
+  uint64_t frees;
+  uint64_t liveBytes;
+  uint64_t totalBytes;
+  uint64_t frameAllocations;
+};
+
+// tracked replacements for malloc and free, used by the global operator new/delete too
+void* allocate(size_t size, Tag tag);
+void* allocate(size_t size);
+void release(void* memory);
+
+// accounts for memory obtained without allocate, e.g. mapped pages
+void track(size_t size, Tag tag);
+
+Tag getTag();
+Tag setTag(Tag tag);
+
+// snapshots the counters so per-frame allocation counts can be reported
+void endFrame();
+
+uint64_t getFrameAllocations();
+uint64_t getLiveAllocations();
+uint64_t getLiveBytes();
+tag_stats_t getTagStats(Tag tag);
+
+const char* getTagName(Tag tag);
+void printReport();
+
+class TagScope {
+public:
+  TagScope(Tag tag) {
+    previous = setTag(tag);
+  }
+
+  ~TagScope() {
+    setTag(previous);
+  }
+
+private:
+  Tag previous;
+};
+
+}
+
+#endif
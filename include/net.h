@@ -0,0 +1,104 @@
+#ifndef NET_H_
+#define NET_H_
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "common.h"
+
+/*
+  framed messages over a unix domain socket or loopback tcp. an address is
+  "tcp:<port>" for 127.0.0.1, anything else is a socket path. every message
+  is a {type, payload size} uint32 header and the payload, numbers are little
+  endian. sockets are non-blocking, Connection buffers both directions
+*/
+namespace Net {
+
+const uint PROTOCOL_VERSION = 1;
+const size_t HEADER_SIZE = 8;
+// larger payloads close the connection, far above a fully encoded chunk
+const size_t MAX_PAYLOAD_SIZE = 1 << 20;
+
+enum MessageType : uint {
+  // server: {version, seed}, sent on connect
+  HELLO = 1,
+  // client: {x, y, z} chunk wanted
+  REQUEST,
+  // client: {x, y, z, distance} drop queued requests further from the chunk
+  PRUNE,
+  // client: {x, y, z, block} world block edited
+  EDIT,
+  // server: {x, y, z} and the run length encoded blocks, see WorldStorage::encodeChunk
+  CHUNK,
+  // server: {x, y, z, block} another client edited a block
+  DELTA
+};
+
+typedef std::shared_ptr<const std::vector<uint8_t>> buffer_ptr;
+
+struct message_t {
+  uint type;
+  const uint8_t* data;
+  size_t size;
+};
+
+// -1 on failure
+int listen(const char* address);
+int connect(const char* address);
+int accept(int listener);
+void close(int handle);
+
+inline void putU32(uint8_t* out, uint value) {
+  out[0] = value & 0xff;
+  out[1] = (value >> 8) & 0xff;
+  out[2] = (value >> 16) & 0xff;
+  out[3] = (value >> 24) & 0xff;
+}
+
+inline uint getU32(const uint8_t* in) {
+  return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint)in[3] << 24);
+}
+
+class Connection {
+public:
+  // takes ownership of the socket
+  Connection(int _handle);
+  ~Connection();
+
+  // small payloads are copied into the send queue
+  void send(uint type, const uint8_t* data, size_t size);
+  // the payload buffer is queued as is and written straight from it, for data shared between clients
+  void send(uint type, const uint8_t* head, size_t headSize, buffer_ptr payload);
+
+  // writes what the socket takes without blocking, false once the connection failed
+  bool flush();
+  // reads what has arrived, false once the peer closed or the stream is broken
+  bool receive();
+  // the next complete message, valid until the next call to receive
+  bool next(message_t* message);
+
+  bool hasPendingSend() const {
+    return !queue.empty();
+  }
+
+  int getHandle() const {
+    return handle;
+  }
+
+private:
+  struct segment_t {
+    buffer_ptr data;
+    size_t offset;
+  };
+
+  int handle;
+  std::deque<segment_t> queue;
+  std::vector<uint8_t> inbox;
+  size_t readOffset;
+  bool broken;
+};
+
+}
+
+#endif
@@ -8,23 +8,34 @@
 
 #include "gl/shader.h"
 
+#include "common.h"
+
 namespace ParticleManager {
 
-struct particle_t {
-  glm::vec3 pos, size;
+/*
+  uploaded once when a particle spawns, the vertex shader animates it from the
+  time uniform. size and motion are pairs of half floats, color is RGBA8
+*/
+struct particle_spawn_t {
+  glm::vec3 origin;
+  float spawnTime;
+  uint size;   // width, height
+  uint motion; // vertical speed, life
   uint color;
-  float speed, life;
-
-  particle_t() : pos({0.0f, 0.0f, 0.0f}), size({1.0f, 1.0f, 1.0f}), speed(0.0f), life(0.0f) {}
 };
 
-extern std::vector<particle_t> particles;
 extern GL::Shader* shader;
 
 void init();
 void free();
-void update(double delta, glm::vec3 cameraPos);
-void draw(glm::mat4 projection, glm::mat4 view);
+// builds the shader again from the asset pack, picking up edited override files
+void reloadShader();
+// time is the simulation clock, draw takes it interpolated to the rendered moment
+void update(double time, glm::vec3 cameraPos);
+void draw(glm::mat4 projection, glm::mat4 view, double time);
+
+// particles in the drawn window of the spawn ring
+uint getLiveCount();
 
 }
 
@@ -0,0 +1,92 @@
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <cstdint>
+
+#include "common.h"
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+
+// times the rest of the enclosing block under the given (string literal) name
+#define PROFILE_SCOPE(x) Profiler::Scope PROFILER_CONCAT(profilerScope, __LINE__)(x);
+
+namespace Profiler {
+
+// events kept per thread, must be a power of two
+const uint EVENT_BUFFER_SIZE = 1 << 16;
+// number of aggregated frames kept for summaries
+const uint FRAME_HISTORY = 240;
+// distinct scope names tracked per frame
+const uint MAX_FRAME_SCOPES = 64;
+
+struct event_t {
+  const char* name;
+  uint64_t start;
+  uint64_t end;
+  uint16_t depth;
+};
+
+struct scope_stats_t {
+  const char* name;
+  uint16_t depth;
+  uint calls;
+  uint64_t time;
+};
+
+struct frame_t {
+  uint64_t start;
+  uint64_t end;
+  uint scopeCount;
+  scope_stats_t scopes[MAX_FRAME_SCOPES];
+};
+
+void init();
+void free();
+
+// nanoseconds since Profiler::init
+uint64_t now();
+
+// names the calling thread in trace output
+void setThreadName(const char* name);
+
+// record a finished scope into the calling thread's buffer
+void record(const char* name, uint64_t start, uint64_t end, uint16_t depth);
+uint16_t pushDepth();
+void popDepth();
+
+// aggregate everything recorded since the last call into the frame history
+void endFrame();
+const frame_t& getFrame(uint framesAgo);
+
+void printSummary();
+bool writeTrace(const char* path);
+
+// startup phases, each ends when the next begins and is timed in wall and process cpu time
+void beginPhase(const char* name);
+void endPhase();
+// one-off events like the first frame, in wall time since init
+void markMilestone(const char* name);
+void printStartup();
+
+class Scope {
+public:
+  Scope(const char* _name) : name(_name) {
+    depth = pushDepth();
+    start = now();
+  }
+
+  ~Scope() {
+    record(name, start, now(), depth);
+    popDepth();
+  }
+
+private:
+  const char* name;
+  uint64_t start;
+  uint16_t depth;
+};
+
+}
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef RAYCAST_H_
+#define RAYCAST_H_
+
+#include <glm/glm.hpp>
+
+#include "common.h"
+#include "blocks.h"
+
+namespace Raycast {
+
+struct ray_t {
+  glm::vec3 origin;
+  glm::vec3 direction;
+  float maxDistance;
+};
+
+struct raycast_hit_t {
+  vec3i block;  // world block coordinates
+  vec3i normal; // face the ray entered through, block + normal is the cell in front of it
+  block_t type;
+  float distance;
+};
+
+/*
+  walks every block the ray passes through (Amanatides & Woo), skipping
+  missing or empty chunks and empty regions of loaded chunks in one step.
+  unloaded chunks count as empty
+*/
+bool cast(glm::vec3 origin, glm::vec3 direction, float maxDistance, raycast_hit_t* hit);
+
+// casts count rays sharing one chunk cache, hits[i] is only valid where results[i] is set
+void castBatch(const ray_t* rays, uint count, raycast_hit_t* hits, bool* results);
+
+}
+
+#endif
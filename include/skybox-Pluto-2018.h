@@ -11,6 +11,8 @@ extern GL::Shader* shader;
 
 void init();
 void free();
+// builds the shader again from the asset pack, picking up edited override files
+void reloadShader();
 void draw(glm::mat4 projection, glm::mat4 view);
 
 };
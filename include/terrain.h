@@ -0,0 +1,70 @@
+#ifndef TERRAIN_H_
+#define TERRAIN_H_
+
+#include <vector>
+
+#include "common.h"
+#include "blocks.h"
+#include "chunk_data.h"
+#include "allocators.h"
+
+/*
+  staged terrain generation on worker threads. every chunk goes through the
+  stages in order, a stage is only queued once the data it reads is ready:
+    DENSITY   stone wherever the 3d density is positive, needs its own column
+    CARVING   caves below the surface
+    SURFACE   grass, dirt and sand layers
+    FEATURES  trees, needs the 3x3 columns around it
+  columns are per (x, z) heightmaps shared by every chunk stacked on them and
+  never change once built. 3d noise is sampled on a coarse lattice cached per
+  chunk position and interpolated per block. a feature crossing a chunk border is placed by
+  every chunk it touches, each writing only its own blocks, so stages never
+  lock or write neighbor chunks
+*/
+namespace Terrain {
+
+enum Stage : uint8_t {
+  DENSITY = 0,
+  CARVING,
+  SURFACE,
+  FEATURES,
+  STAGE_COUNT
+};
+
+// the cube of chunks up to distance from center
+struct area_t {
+  vec3i center;
+  int distance;
+};
+
+struct generated_chunk_t {
+  vec3i pos;
+  block_t* blocks; // allocated from the pool given to init, owned by the caller now
+  uint64_t occupancy;
+};
+
+// the same seed always produces the same world, seed 0 is the original terrain
+void setSeed(uint seed);
+uint getSeed();
+
+// chunk block storage is allocated from pool
+void init(uint threadCount, SlabPool* pool);
+// waits for running stages and drops everything not collected
+void free();
+
+// queues a chunk, does nothing if it is already queued or waiting to be collected
+void request(vec3i pos);
+// moves up to max finished chunks into out, returns how many
+uint collect(std::vector<generated_chunk_t>& out, uint max);
+// drops queued chunks and cached columns further than distance chunks from center
+void prune(vec3i center, int distance);
+// the same for everything outside all of the areas, none drops everything
+void prune(const std::vector<area_t>& areas);
+// drops cached columns and noise lattices that no chunk inside min..max reads, everything still requested must be inside
+void trim(vec3i min, vec3i max);
+
+uint getPendingCount();
+
+}
+
+#endif
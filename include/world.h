@@ -0,0 +1,56 @@
+#ifndef WORLD_H_
+#define WORLD_H_
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "common.h"
+#include "blocks.h"
+
+/*
+  block access in world coordinates. single block calls share a cached last
+  chunk, bulk edits are split per chunk, applied in parallel and remesh and
+  relight each chunk they changed once. unloaded chunks read as air and ignore writes. all
+  calls are main thread only, like the rest of the chunk map
+*/
+namespace World {
+
+// blocks copied out of the world, x fastest then y then z
+struct region_t {
+  vec3i size;
+  std::vector<block_t> blocks;
+};
+
+struct block_edit_t {
+  int x;
+  int y;
+  int z;
+  block_t block;
+};
+
+// drops the cached chunk, call before the chunk manager is freed
+void free();
+
+block_t get(int x, int y, int z);
+// returns false if the chunk holding the block isn't loaded
+bool set(int x, int y, int z, block_t block);
+/*
+  applies the edits in order, later edits of the same block win. the
+  lighting, water and block ticks hear about every edit and each touched
+  chunk remeshes once, so simulations write their whole step through this
+*/
+void setBlocks(const std::vector<block_edit_t>& edits);
+
+// boxes are inclusive on both corners
+void fillBox(vec3i min, vec3i max, block_t block);
+void fillSphere(glm::vec3 center, float radius, block_t block);
+void replace(vec3i min, vec3i max, block_t from, block_t to);
+
+region_t copy(vec3i min, vec3i max);
+// origin is where the region's first block lands, air is skipped unless pasteAir is set
+void paste(const region_t& region, vec3i origin, bool pasteAir = false);
+
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef WORLD_STORAGE_H_
+#define WORLD_STORAGE_H_
+
+#include <vector>
+
+#include "common.h"
+#include "blocks.h"
+#include "chunk_data.h"
+
+/*
+  on-disk worlds. a world is a directory holding world.dat (magic, version,
+  seed) and one r.x.y.z.bin file per region of REGION_SIZE^3 chunks:
+    "CVXR", version, REGION_CHUNKS x {offset, size}, run length encoded chunks
+  chunks are indexed x fastest then y then z, size 0 means not stored. every
+  number is a little endian uint32, runs are {block, uint16 count}
+*/
+namespace WorldStorage {
+
+const uint VERSION = 1;
+const int REGION_SIZE = 4;
+const uint REGION_CHUNKS = REGION_SIZE * REGION_SIZE * REGION_SIZE;
+
+// opens an existing world for loading chunks, false if there is none
+bool open(const char* directory, uint* seed);
+// creates the directory and world.dat. an existing world is refused unless overwrite is set, then its regions are deleted
+bool create(const char* directory, uint seed, bool overwrite);
+void close();
+bool isOpen();
+
+// decodes a stored chunk into blocks, false if the world doesn't have it. thread safe
+bool loadChunk(int x, int y, int z, block_t* blocks);
+
+// chunks holds REGION_CHUNKS block arrays, nullptr for chunks that aren't stored
+bool writeRegion(const char* directory, vec3i region, const block_t* const* chunks);
+
+// the run length encoding of stored chunks, also used for chunks sent over the network. encode appends to out
+void encodeChunk(const block_t* blocks, std::vector<uint8_t>& out);
+bool decodeChunk(const uint8_t* in, size_t size, block_t* blocks);
+
+inline int toRegionCoord(int chunk) {
+  return (chunk < 0 ? chunk - (REGION_SIZE - 1) : chunk) / REGION_SIZE;
+}
+
+}
+
+#endif
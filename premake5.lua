@@ -89,6 +89,7 @@ workspace "cppvoxel"
       os.rmdir("obj")
       os.rmdir("build")
       os.rmdir("embed")
+      os.remove("assets.pak")
     end,
     ["onEnd"] = function()
       print "Done."
@@ -97,20 +98,16 @@ workspace "cppvoxel"
 
   newaction {
     ["trigger"] = "embed",
-    ["description"] = "Embed resource files",
+    ["description"] = "Build the asset pack",
     ["execute"] = function ()
       os.execute("premake5 gmake2")
       buildProject("embed_images", true)
-      buildProject("embed_shaders", true)
-
-      print "Embeding resources..."
-      os.mkdir("embed/res")
-      res = os.matchfiles("res/*.png")
-      for _, resFile in ipairs(res) do
-        resFile = string.sub(resFile, string.find(resFile, "/[^/]*$") + 1, string.find(resFile, ".[^.]*$") - 1)
-        os.execute(getToolBuildPath("embed_images").." "..resFile)
-      end
-      os.execute(getToolBuildPath("embed_shaders"))
+      buildProject("pack_assets", true)
+
+      print "Packing assets..."
+      os.mkdir("embed")
+      os.execute(getToolBuildPath("embed_images"))
+      os.execute(getToolBuildPath("pack_assets"))
     end
  }
 
@@ -126,15 +123,59 @@ workspace "cppvoxel"
 project "embed_images"
   targetdir "bin/tools"
   files {"tools/embed_images.cpp"}
+  includedirs {"../cppgl/vendors"}
+
+project "pack_assets"
+  targetdir "bin/tools"
+  files {"tools/pack_assets.cpp", "src/asset_pack.cpp"}
+  includedirs {"include"}
+
+-- everything but rendering, builds and links without opengl, glew or glfw
+project "cppvoxel-core"
+  kind "StaticLib"
+  targetdir "bin/lib"
+  files {
+    "src/common-Pluto-2018.cpp", "src/config-Pluto-2018.cpp", "src/allocators.cpp", "src/memory_tracker.cpp", "src/profiler.cpp", "src/asset_pack.cpp",
+    "src/terrain.cpp", "src/world_storage.cpp", "src/chunk.cpp", "src/chunk_manager.cpp", "src/lighting.cpp", "src/world.cpp", "src/fluids.cpp",
+    "src/block_ticks.cpp", "src/raycast.cpp", "src/camera.cpp", "src/net.cpp", "src/chunk_stream.cpp"
+  }
+  includedirs {"../cppgl/vendors/glm", "include"}
 
-project "embed_shaders"
+-- uploads and draws what the core produces
+project "cppvoxel-renderer"
+  kind "StaticLib"
+  targetdir "bin/lib"
+  files {"src/gl/**.cpp", "src/glfw/**.cpp", "src/chunk_renderer.cpp", "src/particle_manager.cpp", "src/skybox-Pluto-2018.cpp"}
+  includedirs {"../cppgl/vendors", "../cppgl/vendors/glm", "include"}
+  defines {"GLEW_STATIC"}
+
+project "cppvoxel-pregen"
   targetdir "bin/tools"
-  files {"tools/embed_shaders.cpp"}
+  files {"tools/pregen.cpp"}
+  includedirs {"../cppgl/vendors/glm", "include"}
+  links {"cppvoxel-core"}
+
+  filter {"system:not windows"}
+    links {"pthread"}
+
+  filter {}
+
+project "cppvoxel-server"
+  targetdir "bin/tools"
+  files {"tools/server.cpp"}
+  includedirs {"../cppgl/vendors/glm", "include"}
+  links {"cppvoxel-core"}
+
+  filter {"system:not windows"}
+    links {"pthread"}
+
+  filter {}
 
 project "cppvoxel"
-  files {"src/**.cpp"}
+  files {"src/main.cpp"}
 
-  includedirs {"../cppgl/vendors", "../cppgl/vendors/glm", "include", "embed"}
+  includedirs {"../cppgl/vendors", "../cppgl/vendors/glm", "include"}
+  links {"cppvoxel-renderer", "cppvoxel-core"}
 
   local git_hash = getCmdOutput("git rev-parse HEAD")
   local git_tag = getCmdOutput("git describe --tags --candidates 1")
@@ -8,8 +8,8 @@ in float vDiffuse;
 
 uniform sampler2DArray texture_array;
 
-uniform int fog_near;
-uniform int fog_far;
+uniform float fog_near;
+uniform float fog_far;
 
 void main() {
   vec4 color = vec4(texture(texture_array, vTexCoord).rgb * vDiffuse, 1.0);
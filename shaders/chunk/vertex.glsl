@@ -1,6 +1,7 @@
 #version 330 core
 
-layout(location = 0) in int aVertex;
+// x: position, normal, texture. y: light of the block the face looks into, sun << 4 | block
+layout(location = 0) in ivec2 aVertex;
 
 out vec3 vPosition;
 out vec3 vTexCoord;
@@ -12,6 +13,9 @@ uniform mat4 model;
 
 const vec3 sun_direction = normalize(vec3(1, 3, 2));
 const float ambient = 0.4f;
+// each light level below full is this much darker, never quite black
+const float light_falloff = 0.8f;
+const float min_light = 0.05f;
 
 const vec3 normalCoords[] = vec3[](
                               vec3(0.0, 1.0, 0.0),
@@ -23,14 +27,16 @@ const vec3 normalCoords[] = vec3[](
                             );
 
 void main() {
-  vec3 aPosition = vec3(float(aVertex & (63)), float((aVertex >> 6) & (63)), float((aVertex >> 12) & (63)));
-  int aNormal = (aVertex >> 18) & (7);
+  int vertex = aVertex.x;
+  vec3 aPosition = vec3(float(vertex & (63)), float((vertex >> 6) & (63)), float((vertex >> 12) & (63)));
+  int aNormal = (vertex >> 18) & (7);
 
-  int aTextureId = (aVertex >> 21) & (255);
+  int aTextureId = (vertex >> 21) & (255);
 
   vPosition = (view * model * vec4(aPosition, 1.0)).xyz;
-  vTexCoord = vec3(float((aVertex >> 29) & (1)), float((aVertex >> 30) & (1)), aTextureId);
-  vDiffuse = (max(dot(normalCoords[aNormal], sun_direction), 0.0) + ambient);
+  vTexCoord = vec3(float((vertex >> 29) & (1)), float((vertex >> 30) & (1)), aTextureId);
+  int level = max(aVertex.y >> 4, aVertex.y & 15);
+  vDiffuse = (max(dot(normalCoords[aNormal], sun_direction), 0.0) + ambient) * max(pow(light_falloff, float(15 - level)), min_light);
 
   gl_Position = projection * vec4(vPosition, 1.0);
 }
@@ -1,15 +1,46 @@
 #version 330 core
 
-layout(location = 0) in vec3 aPosition;
-layout(location = 1) in vec4 aColor;
-layout(location = 2) in mat4 aTransform;
+layout(location = 0) in vec2 aCorner;
+layout(location = 1) in vec4 aOrigin; // xyz origin, w spawn time
+layout(location = 2) in vec4 aShape;  // x width, y height, z vertical speed, w life
+layout(location = 3) in vec4 aColor;
 
 flat out vec4 vColor;
 
 uniform mat4 projection;
 uniform mat4 view;
 
+uniform float time;
+uniform float time_wrap;
+
 void main() {
+  float age = mod(time - aOrigin.w, time_wrap);
+
+  // expired, move every vertex outside the clip volume so the instance is discarded
+  if(age > aShape.w) {
+    vColor = vec4(0.0);
+    gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+    return;
+  }
+
+  vec3 position = aOrigin.xyz + vec3(0.0, aShape.z * age, 0.0);
+
+  // camera facing basis taken from the view matrix
+  vec3 right = vec3(view[0][0], view[1][0], view[2][0]);
+  vec3 up = vec3(view[0][1], view[1][1], view[2][1]);
+
+  // streaks stay aligned with their (vertical) motion and only turn around it to face the camera
+  if(aShape.y > aShape.x * 2.0) {
+    vec3 cameraPosition = -transpose(mat3(view)) * view[3].xyz;
+    vec3 toCamera = cameraPosition - position;
+    toCamera.y = 0.0;
+
+    if(dot(toCamera, toCamera) > 0.0001) {
+      up = vec3(0.0, 1.0, 0.0);
+      right = normalize(cross(up, toCamera));
+    }
+  }
+
   vColor = aColor;
-  gl_Position = projection * view * aTransform * vec4(aPosition, 1.0);
+  gl_Position = projection * view * vec4(position + right * aCorner.x * aShape.x + up * aCorner.y * aShape.y, 1.0);
 }
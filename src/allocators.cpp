@@ -0,0 +1,208 @@
+#include "allocators.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// slabs are sized and aligned to this so the kernel can back them with huge pages
+const static size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+inline size_t alignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+SlabPool::SlabPool(size_t _blockSize, uint _blocksPerSlab, MemoryTracker::Tag _tag) {
+  // blocks double as free list nodes
+  blockSize = alignUp(MAX(_blockSize, sizeof(void*)), 16);
+  blocksPerSlab = _blocksPerSlab;
+  tag = _tag;
+  hugePages = false;
+  freeList = nullptr;
+  blocksInUse = 0;
+}
+
+SlabPool::~SlabPool() {
+  for(size_t i = 0; i < slabs.size(); i++) {
+#ifdef __linux__
+
+    if(hugePages) {
+      munmap(slabs[i], slabSizes[i]);
+      continue;
+    }
+
+#endif
+    MemoryTracker::release(slabs[i]);
+  }
+}
+
+void SlabPool::setHugePages(bool value) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  // slabs remember how they were allocated through the flag, so it can only change while empty
+  if(slabs.empty()) {
+    hugePages = value;
+  }
+}
+
+void* SlabPool::allocate() {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  if(freeList == nullptr) {
+    addSlab();
+  }
+
+  void* block = freeList;
+  freeList = *(void**)block;
+  blocksInUse++;
+
+  return block;
+}
+
+void SlabPool::release(void* block) {
+  if(block == nullptr) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  *(void**)block = freeList;
+  freeList = block;
+  blocksInUse--;
+}
+
+uint SlabPool::getSlabCount() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return (uint)slabs.size();
+}
+
+uint SlabPool::getBlocksInUse() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return blocksInUse;
+}
+
+void SlabPool::addSlab() {
+  size_t size = blockSize * blocksPerSlab;
+  uint8_t* slab = nullptr;
+
+#ifdef __linux__
+
+  if(hugePages) {
+    size = alignUp(size, HUGE_PAGE_SIZE);
+
+    // over-allocate so the slab can be trimmed down to a huge page boundary
+    size_t mappedSize = size + HUGE_PAGE_SIZE;
+    uint8_t* mapped = (uint8_t*)mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if(mapped == MAP_FAILED) {
+      fprintf(stderr, "%s: unable to map %zu bytes\n", __func__, mappedSize);
+      exit(-1);
+    }
+
+    slab = (uint8_t*)alignUp((size_t)mapped, HUGE_PAGE_SIZE);
+    size_t head = slab - mapped;
+    size_t tail = mappedSize - head - size;
+
+    if(head > 0) {
+      munmap(mapped, head);
+    }
+
+    if(tail > 0) {
+      munmap(slab + size, tail);
+    }
+
+    madvise(slab, size, MADV_HUGEPAGE);
+    MemoryTracker::track(size, tag);
+  }
+
+#endif
+
+  if(slab == nullptr) {
+    slab = (uint8_t*)MemoryTracker::allocate(size, tag);
+
+    if(slab == nullptr) {
+      fprintf(stderr, "%s: unable to allocate %zu bytes\n", __func__, size);
+      exit(-1);
+    }
+  }
+
+  slabs.push_back(slab);
+  slabSizes.push_back(size);
+
+  // thread the new blocks onto the free list in address order
+  for(uint i = blocksPerSlab; i > 0; i--) {
+    void* block = slab + (i - 1) * blockSize;
+    *(void**)block = freeList;
+    freeList = block;
+  }
+}
+
+namespace FrameArena {
+const size_t INITIAL_SIZE = 1024 * 1024;
+
+uint8_t* block = nullptr;
+size_t capacity = 0;
+size_t used = 0;
+
+// blocks that filled up during this frame, merged into one on reset
+std::vector<uint8_t*> retired;
+size_t retiredCapacity = 0;
+}
+
+void* FrameArena::allocate(size_t size) {
+  size = alignUp(size, 16);
+
+  if(used + size > capacity) {
+    if(block != nullptr) {
+      retired.push_back(block);
+      retiredCapacity += capacity;
+    }
+
+    capacity = MAX(MAX(capacity * 2, INITIAL_SIZE), size);
+    block = (uint8_t*)MemoryTracker::allocate(capacity, MemoryTracker::GENERAL);
+    used = 0;
+  }
+
+  void* ptr = block + used;
+  used += size;
+
+  return ptr;
+}
+
+void FrameArena::reset() {
+  if(!retired.empty()) {
+    // this frame needed more than one block, size the next one to fit it all
+    size_t total = retiredCapacity + capacity;
+
+    for(uint8_t* retiredBlock : retired) {
+      MemoryTracker::release(retiredBlock);
+    }
+
+    retired.clear();
+    retiredCapacity = 0;
+
+    MemoryTracker::release(block);
+    capacity = total;
+    block = (uint8_t*)MemoryTracker::allocate(capacity, MemoryTracker::GENERAL);
+  }
+
+  used = 0;
+}
+
+void FrameArena::free() {
+  reset();
+  MemoryTracker::release(block);
+  block = nullptr;
+  capacity = 0;
+}
+
+size_t FrameArena::getUsed() {
+  return retiredCapacity + used;
+}
+
+size_t FrameArena::getCapacity() {
+  return retiredCapacity + capacity;
+}
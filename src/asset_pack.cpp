@@ -0,0 +1,260 @@
+#include "asset_pack.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <map>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+const static char PACK_MAGIC[4] = {'C', 'V', 'X', 'A'};
+const static size_t HEADER_SIZE = 16;
+const static size_t ENTRY_SIZE = AssetPack::NAME_LENGTH + 8;
+
+namespace AssetPack {
+const uint8_t* pack = nullptr;
+size_t packSize = 0;
+uint entryCount = 0;
+
+#ifdef _WIN32
+HANDLE file = INVALID_HANDLE_VALUE;
+HANDLE mapping = NULL;
+#endif
+
+std::string overridePath;
+// override files read by get, replaced when the same asset is asked for again
+std::map<std::string, std::vector<uint8_t>> overrides;
+}
+
+inline void putU32(std::vector<uint8_t>& out, uint value) {
+  out.push_back(value & 0xff);
+  out.push_back((value >> 8) & 0xff);
+  out.push_back((value >> 16) & 0xff);
+  out.push_back((value >> 24) & 0xff);
+}
+
+inline uint getU32(const uint8_t* in) {
+  return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint)in[3] << 24);
+}
+
+static bool mapFile(const char* path) {
+  using namespace AssetPack;
+
+#ifdef _WIN32
+  file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+  if(file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER size;
+  GetFileSizeEx(file, &size);
+  packSize = (size_t)size.QuadPart;
+  mapping = packSize > 0 ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+
+  if(mapping == NULL) {
+    CloseHandle(file);
+    file = INVALID_HANDLE_VALUE;
+    return false;
+  }
+
+  pack = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+  if(pack == nullptr) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    mapping = NULL;
+    file = INVALID_HANDLE_VALUE;
+    return false;
+  }
+#else
+  int fd = ::open(path, O_RDONLY);
+
+  if(fd < 0) {
+    return false;
+  }
+
+  struct stat info;
+
+  if(fstat(fd, &info) != 0 || info.st_size <= 0) {
+    ::close(fd);
+    return false;
+  }
+
+  packSize = (size_t)info.st_size;
+  void* mapped = mmap(NULL, packSize, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  // the mapping keeps the file referenced on its own
+  ::close(fd);
+
+  if(mapped == MAP_FAILED) {
+    return false;
+  }
+
+  pack = (const uint8_t*)mapped;
+#endif
+
+  return true;
+}
+
+bool AssetPack::open(const char* path, const char* overrideDirectory) {
+  close();
+
+  overridePath = overrideDirectory != nullptr ? overrideDirectory : "";
+
+  if(!mapFile(path)) {
+    fprintf(stderr, "%s: unable to map %s\n", __func__, path);
+    return false;
+  }
+
+  if(packSize < HEADER_SIZE || memcmp(pack, PACK_MAGIC, 4) != 0 || getU32(pack + 4) != VERSION) {
+    fprintf(stderr, "%s: %s is not a version %u asset pack\n", __func__, path, VERSION);
+    close();
+    return false;
+  }
+
+  entryCount = getU32(pack + 8);
+
+  if(HEADER_SIZE + entryCount * ENTRY_SIZE > packSize) {
+    fprintf(stderr, "%s: %s is truncated\n", __func__, path);
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+void AssetPack::close() {
+  if(pack != nullptr) {
+#ifdef _WIN32
+    UnmapViewOfFile(pack);
+    CloseHandle(mapping);
+    CloseHandle(file);
+    mapping = NULL;
+    file = INVALID_HANDLE_VALUE;
+#else
+    munmap((void*)pack, packSize);
+#endif
+  }
+
+  pack = nullptr;
+  packSize = 0;
+  entryCount = 0;
+  overrides.clear();
+}
+
+static bool getOverride(const char* name, AssetPack::asset_t* asset) {
+  using namespace AssetPack;
+
+  if(overridePath.empty()) {
+    return false;
+  }
+
+  FILE* file = fopen((overridePath + "/" + name).c_str(), "rb");
+
+  if(file == NULL) {
+    return false;
+  }
+
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  std::vector<uint8_t>& data = overrides[name];
+  data.resize(size > 0 ? size : 0);
+  bool ok = fread(data.data(), 1, data.size(), file) == data.size();
+  fclose(file);
+
+  if(!ok) {
+    fprintf(stderr, "%s: unable to read override %s\n", __func__, name);
+    overrides.erase(name);
+    return false;
+  }
+
+  asset->data = data.data();
+  asset->size = data.size();
+
+  return true;
+}
+
+bool AssetPack::get(const char* name, asset_t* asset) {
+  if(getOverride(name, asset)) {
+    return true;
+  }
+
+  // few enough entries that a linear scan of the index is cheaper than building a map
+  for(uint i = 0; i < entryCount; i++) {
+    const uint8_t* entry = pack + HEADER_SIZE + i * ENTRY_SIZE;
+
+    if(strncmp((const char*)entry, name, NAME_LENGTH) != 0) {
+      continue;
+    }
+
+    uint offset = getU32(entry + NAME_LENGTH);
+    uint size = getU32(entry + NAME_LENGTH + 4);
+
+    if((size_t)offset + size > packSize) {
+      fprintf(stderr, "%s: %s points past the end of the pack\n", __func__, name);
+      return false;
+    }
+
+    asset->data = pack + offset;
+    asset->size = size;
+
+    return true;
+  }
+
+  return false;
+}
+
+bool AssetPack::write(const char* path, const asset_list& assets) {
+  std::vector<uint8_t> out;
+
+  out.insert(out.end(), PACK_MAGIC, PACK_MAGIC + 4);
+  putU32(out, VERSION);
+  putU32(out, (uint)assets.size());
+  putU32(out, 0);
+
+  size_t offset = HEADER_SIZE + assets.size() * ENTRY_SIZE;
+
+  for(const std::pair<std::string, std::vector<uint8_t>>& asset : assets) {
+    // names are NUL padded, so one that fills the field could never be found
+    if(asset.first.size() >= NAME_LENGTH) {
+      fprintf(stderr, "%s: asset name %s is too long\n", __func__, asset.first.c_str());
+      return false;
+    }
+
+    offset = (offset + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1);
+
+    char name[NAME_LENGTH] = {0};
+    memcpy(name, asset.first.c_str(), asset.first.size());
+    out.insert(out.end(), name, name + NAME_LENGTH);
+    putU32(out, (uint)offset);
+    putU32(out, (uint)asset.second.size());
+
+    offset += asset.second.size();
+  }
+
+  for(const std::pair<std::string, std::vector<uint8_t>>& asset : assets) {
+    out.resize((out.size() + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1), 0);
+    out.insert(out.end(), asset.second.begin(), asset.second.end());
+  }
+
+  FILE* file = fopen(path, "wb");
+
+  if(file == NULL) {
+    fprintf(stderr, "%s: unable to write %s\n", __func__, path);
+    return false;
+  }
+
+  bool ok = fwrite(out.data(), 1, out.size(), file) == out.size();
+  fclose(file);
+
+  return ok;
+}
@@ -0,0 +1,195 @@
+#include "block_ticks.h"
+
+#include <set>
+#include <vector>
+#include <memory>
+
+#include "chunk_manager.h"
+#include "world.h"
+#include "profiler.h"
+
+// slots of the timing wheel, longer delays go around it more than once
+const uint WHEEL_SIZE = 256;
+
+// blocks sampled per tickable chunk per tick, each block gets a random tick about every 70 seconds at 60 ticks
+const uint RANDOM_TICKS_PER_CHUNK = 8;
+
+// ticks sand waits before dropping a block
+const uint SAND_FALL_DELAY = 6;
+
+struct scheduled_tick_t {
+  vec3i pos;
+  uint64_t due;
+};
+
+namespace BlockTicks {
+uint64_t currentTick = 0;
+std::vector<scheduled_tick_t> wheel[WHEEL_SIZE];
+// blocks in the wheel, so a block is never ticked twice for the same change
+std::set<vec3i> scheduled;
+std::vector<scheduled_tick_t> firing;
+
+// chunks that held random tickable blocks when last seen, dropped lazily once they don't
+std::set<vec3i> tickableChunks;
+
+std::vector<World::block_edit_t> edits;
+uint randomState = 0x2545f491;
+}
+
+// xorshift32, like the particles
+inline uint nextRandom(uint& state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+// how long a block waits after it or a neighbor changed, 0 for blocks that don't care
+inline uint getScheduleDelay(block_t block) {
+  return block == SAND ? SAND_FALL_DELAY : 0;
+}
+
+static void sandTick(vec3i pos) {
+  // unloaded chunks read as air and drop writes, the sand would vanish. try again once it may have loaded
+  if(ChunkManager::get({toChunkCoord(pos.x), toChunkCoord(pos.y - 1), toChunkCoord(pos.z)}) == nullptr) {
+    BlockTicks::schedule(pos.x, pos.y, pos.z, SAND_FALL_DELAY);
+    return;
+  }
+
+  block_t below = World::get(pos.x, pos.y - 1, pos.z);
+
+  // sand displaces water, the water simulation refills around it
+  if(below == AIR || isWater(below)) {
+    BlockTicks::edits.push_back({pos.x, pos.y, pos.z, AIR});
+    BlockTicks::edits.push_back({pos.x, pos.y - 1, pos.z, SAND});
+  }
+}
+
+static void grassTick(vec3i pos) {
+  uint& random = BlockTicks::randomState;
+
+  // covered grass dies
+  if(!isLightTransparent(World::get(pos.x, pos.y + 1, pos.z))) {
+    BlockTicks::edits.push_back({pos.x, pos.y, pos.z, DIRT});
+    return;
+  }
+
+  // spreads onto uncovered dirt within a 3x5x3 box, further down than up
+  uint r = nextRandom(random);
+  vec3i target = {pos.x + (int)(r % 3) - 1, pos.y + (int)((r >> 8) % 5) - 3, pos.z + (int)((r >> 16) % 3) - 1};
+
+  if(World::get(target.x, target.y, target.z) == DIRT) {
+    block_t above = World::get(target.x, target.y + 1, target.z);
+
+    if(isLightTransparent(above) && !isWater(above)) {
+      BlockTicks::edits.push_back({target.x, target.y, target.z, GRASS});
+    }
+  }
+}
+
+void BlockTicks::free() {
+  for(uint i = 0; i < WHEEL_SIZE; i++) {
+    wheel[i].clear();
+  }
+
+  scheduled.clear();
+  firing.clear();
+  tickableChunks.clear();
+  edits.clear();
+  currentTick = 0;
+}
+
+void BlockTicks::schedule(int x, int y, int z, uint delay) {
+  vec3i pos = {x, y, z};
+
+  if(!scheduled.insert(pos).second) {
+    return;
+  }
+
+  uint64_t due = currentTick + MAX(delay, 1u);
+  wheel[due % WHEEL_SIZE].push_back({pos, due});
+}
+
+void BlockTicks::neighborChanged(int x, int y, int z) {
+  uint delay = getScheduleDelay(World::get(x, y, z));
+
+  if(delay > 0) {
+    schedule(x, y, z, delay);
+  }
+}
+
+void BlockTicks::blockChanged(int x, int y, int z) {
+  const int offsets[7][3] = {{0, 0, 0}, {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+
+  for(uint i = 0; i < 7; i++) {
+    neighborChanged(x + offsets[i][0], y + offsets[i][1], z + offsets[i][2]);
+  }
+
+  if(isRandomTickable(World::get(x, y, z))) {
+    tickableChunks.insert({toChunkCoord(x), toChunkCoord(y), toChunkCoord(z)});
+  }
+}
+
+void BlockTicks::chunkChanged(vec3i pos) {
+  std::shared_ptr<Chunk> chunk = ChunkManager::get(pos);
+
+  if(chunk != nullptr && chunk->tickableCount > 0) {
+    tickableChunks.insert(pos);
+  }
+}
+
+void BlockTicks::tick() {
+  PROFILE_SCOPE("block ticks")
+
+  currentTick++;
+
+  // ticks due now, anything a full turn or more away goes back into the slot
+  std::vector<scheduled_tick_t>& slot = wheel[currentTick % WHEEL_SIZE];
+  firing.swap(slot);
+
+  for(const scheduled_tick_t& entry : firing) {
+    if(entry.due != currentTick) {
+      slot.push_back(entry);
+      continue;
+    }
+
+    scheduled.erase(entry.pos);
+
+    if(World::get(entry.pos.x, entry.pos.y, entry.pos.z) == SAND) {
+      sandTick(entry.pos);
+    }
+  }
+
+  firing.clear();
+
+  for(std::set<vec3i>::iterator it = tickableChunks.begin(); it != tickableChunks.end();) {
+    std::shared_ptr<Chunk> chunk = ChunkManager::get(*it);
+
+    if(chunk == nullptr || chunk->tickableCount == 0) {
+      it = tickableChunks.erase(it);
+      continue;
+    }
+
+    const block_t* blocks = chunk->getBlocks();
+
+    for(uint i = 0; i < RANDOM_TICKS_PER_CHUNK; i++) {
+      uint index = nextRandom(randomState) & (CHUNK_SIZE_CUBED - 1);
+
+      if(blocks[index] == GRASS) {
+        grassTick({chunk->x * CHUNK_SIZE + (int)(index & (CHUNK_SIZE - 1)), chunk->y * CHUNK_SIZE + (int)((index >> 5) & (CHUNK_SIZE - 1)), chunk->z * CHUNK_SIZE + (int)(index >> 10)});
+      }
+    }
+
+    it++;
+  }
+
+  // edits made by this tick schedule their neighbors for the following ones
+  if(!edits.empty()) {
+    World::setBlocks(edits);
+    edits.clear();
+  }
+}
+
+uint BlockTicks::getScheduledCount() {
+  return (uint)scheduled.size();
+}
@@ -2,20 +2,18 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
-#include <glm/gtc/noise.hpp>
-
-#include "gl/buffer.h"
-
 #include "chunk_manager.h"
-#include "timer.h"
+#include "lighting.h"
+#include "allocators.h"
+#include "memory_tracker.h"
+#include "profiler.h"
 
 #define sign(_x) ({ __typeof__(_x) _xx = (_x);\
   ((__typeof__(_x)) ( (((__typeof__(_x)) 0) < _xx) - (_xx < ((__typeof__(_x)) 0))));})
 
-#define WATER_LEVEL 57
-
 enum NormalFace : uint8_t {
   PY = 0,
   NY,
@@ -29,10 +27,6 @@ inline float lerp(float a, float b, float t) {
   return a * (1.0f - t) + b * t;
 }
 
-inline ushort blockIndex(uint8_t x, uint8_t y, uint8_t z) {
-  return x | (y << 5) | (z << 10);
-}
-
 // check if a block ID is transparent
 inline bool isTransparent(block_t block) {
   return block == AIR || block == GLASS;
@@ -48,105 +42,63 @@ inline int packVertex(uint8_t x, uint8_t y, uint8_t z, NormalFace normal, uint8_
   return x | (y << 6) | (z << 12) | (normal << 18) | (textureId << 21) | (texX << 29) | (texY << 30);
 }
 
-float getHeight(int x, int z, int xCS, int zCS, int octaves, float roughness, float smoothness, float amplitude) {
-  float xCoord = (float)(x + xCS);
-  float zCoord = (float)(z + zCS);
-  float totalValue = 0.0f;
+// a vertex is two ints, the packed vertex and the light in front of its face
+inline void pushVertex(std::vector<int>& vertices, uint8_t light, int vertex) {
+  vertices.push_back(vertex);
+  vertices.push_back(light);
+}
+
+SlabPool Chunk::blockPool(CHUNK_SIZE_CUBED * sizeof(block_t), 64, MemoryTracker::CHUNK_STORAGE);
+SlabPool Chunk::lightPool(CHUNK_SIZE_CUBED, 64, MemoryTracker::CHUNK_STORAGE);
 
-  float frequency, _amplitude;
+// per thread mesh buffer, reserved for the worst case once so meshing never reallocates
+static std::vector<int>& getMeshScratch() {
+  thread_local std::vector<int> scratch;
 
-  for(int octave = 0; octave < octaves - 1; octave++) {
-    frequency = glm::pow(2.0f, octave);
-    _amplitude = glm::pow(roughness, octave);
-    totalValue += glm::simplex(glm::vec2{xCoord* frequency / smoothness, zCoord* frequency / smoothness}) * _amplitude;
+  if(scratch.capacity() < MAX_CHUNK_VERTICES * 2) {
+    MEMORY_TAG(MemoryTracker::MESHING)
+    scratch.reserve(MAX_CHUNK_VERTICES * 2);
   }
 
-  return ((totalValue / 2.1f) + 1.2f) * amplitude;
+  scratch.clear();
+  return scratch;
 }
 
-Chunk::Chunk(int _x, int _y, int _z) {
-#ifdef PRINT_TIMING
-  Timer timer;
-  unsigned short count = 0;
-#endif
+// takes ownership of blocks, which must come from blockPool
+Chunk::Chunk(int _x, int _y, int _z, block_t* _blocks, uint64_t _occupancy) {
+  blocks = _blocks;
+  light = (uint8_t*)lightPool.allocate();
+  memset(light, 0, CHUNK_SIZE_CUBED);
+  lit = false;
+  seeding = false;
 
-  blocks = (block_t*)malloc(CHUNK_SIZE_CUBED * sizeof(block_t));
-
-  vao = nullptr;
+  vertexData = nullptr;
   elements = 0;
-  changed = false;
-  empty = true;
+  occupancy = _occupancy;
   meshChanged = false;
 
   x = _x;
   y = _y;
   z = _z;
 
-  // precalculate chunk position in block coordinates
-  const int xCS = x * CHUNK_SIZE;
-  const int yCS = y * CHUNK_SIZE;
-  const int zCS = z * CHUNK_SIZE;
-
-  model = glm::translate(glm::mat4(1.0f), glm::vec3(xCS, yCS, zCS));
-
-  int height, thickness;
-  uint8_t dx, dy, dz;
-  block_t block;
-
-  for(dx = 0; dx < CHUNK_SIZE; dx++) {
-    for(dz = 0; dz < CHUNK_SIZE; dz++) {
-      height = (int)getHeight(dx, dz, xCS, zCS, 8, 0.4f, 400.0f, 100.0f);
-
-      for(dy = 0; dy < CHUNK_SIZE; dy++) {
-        if(height < WATER_LEVEL) {
-          height = WATER_LEVEL;
-        }
-
-        thickness = height - (dy + yCS);
-
-        block = dy + yCS <= height ?
-                height <= WATER_LEVEL && thickness <= 1 ? WATER :
-                height <= WATER_LEVEL + 3 && thickness <= 4 ? SAND :
-                thickness == 0 ? GRASS :
-                thickness <= 3 ? DIRT :
-                STONE
-                : AIR;
-        blocks[blockIndex(dx, dy, dz)] = block;
-
-        if(empty && block != AIR) {
-          changed = true;
-          empty = false;
-        }
-
-#ifdef PRINT_TIMING
+  model = glm::translate(glm::mat4(1.0f), glm::vec3(x * CHUNK_SIZE, y * CHUNK_SIZE, z * CHUNK_SIZE));
 
-        if(block != AIR) {
-          count++;
-        }
+  empty = occupancy == 0;
+  changed = !empty;
 
-#endif
-      }
-    }
-  }
-
-#ifdef PRINT_TIMING
-  printf("chunk gen: %d blocks ", count);
-#endif
+  countTickable();
 }
 
 Chunk::~Chunk() {
-  if(vao != nullptr) {
-    delete vao;
-  }
-
-  // delete the stored data
-  free(blocks);
+  // return the stored data to the pool
+  blockPool.release(blocks);
+  lightPool.release(light);
 }
 
 // update the chunk
 bool Chunk::update() {
-  // if the chunk does not need to remesh then stop
-  if(!changed) {
+  // if the chunk does not need to remesh then stop, unlit chunks would flash dark
+  if(!changed || !lit) {
     return false;
   }
 
@@ -165,15 +117,23 @@ bool Chunk::update() {
   }
 
   STACK_TRACE_PUSH("update chunk")
+  PROFILE_SCOPE("chunk mesh")
+  MEMORY_TAG(MemoryTracker::MESHING)
 
-#ifdef PRINT_TIMING
-  Timer timer;
-#endif
+  // the lighting worker writes the light of this chunk and its neighbors
+  std::lock_guard<std::mutex> lock(Lighting::mutex);
+
+  // its light is half rebuilt, meshed once the worker is done
+  if(seeding) {
+    return false;
+  }
 
   // updating is taken care of - reset flag
   changed = false;
 
-  uint8_t w, _x, _y, _z;
+  std::vector<int>& vertices = getMeshScratch();
+
+  uint8_t w, l, _x, _y, _z;
   block_t block;
 
   for(_z = 0; _z < CHUNK_SIZE; _z++) {
@@ -187,165 +147,200 @@ bool Chunk::update() {
 
         // add a face if -x is transparent
         if(isTransparent(get(_x - 1, _y, _z, px, nx, py, ny, pz, nz))) {
+          l = getLight(_x - 1, _y, _z, px, nx, py, ny, pz, nz);
           w = BLOCKS[block][0]; // get texture coordinates
 
-          vertexData.push_back(packVertex(_x, _y, _z, NX, w, 0, 0));
-          vertexData.push_back(packVertex(_x, _y + 1, _z + 1, NX, w, 1, 1));
-          vertexData.push_back(packVertex(_x, _y + 1, _z, NX, w, 0, 1));
-          vertexData.push_back(packVertex(_x, _y, _z, NX, w, 0, 0));
-          vertexData.push_back(packVertex(_x, _y, _z + 1, NX, w, 1, 0));
-          vertexData.push_back(packVertex(_x, _y + 1, _z + 1, NX, w, 1, 1));
+          pushVertex(vertices, l, packVertex(_x, _y, _z, NX, w, 0, 0));
+          pushVertex(vertices, l, packVertex(_x, _y + 1, _z + 1, NX, w, 1, 1));
+          pushVertex(vertices, l, packVertex(_x, _y + 1, _z, NX, w, 0, 1));
+          pushVertex(vertices, l, packVertex(_x, _y, _z, NX, w, 0, 0));
+          pushVertex(vertices, l, packVertex(_x, _y, _z + 1, NX, w, 1, 0));
+          pushVertex(vertices, l, packVertex(_x, _y + 1, _z + 1, NX, w, 1, 1));
         }
 
         // add a face if +x is transparent
         if(isTransparent(get(_x + 1, _y, _z, px, nx, py, ny, pz, nz))) {
+          l = getLight(_x + 1, _y, _z, px, nx, py, ny, pz, nz);
           w = BLOCKS[block][1]; // get texture coordinates
 
-          vertexData.push_back(packVertex(_x + 1, _y, _z, PX, w, 1, 0));
-          vertexData.push_back(packVertex(_x + 1, _y + 1, _z + 1, PX, w, 0, 1));
-          vertexData.push_back(packVertex(_x + 1, _y, _z + 1, PX, w, 0, 0));
-          vertexData.push_back(packVertex(_x + 1, _y, _z, PX, w, 1, 0));
-          vertexData.push_back(packVertex(_x + 1, _y + 1, _z, PX, w, 1, 1));
-          vertexData.push_back(packVertex(_x + 1, _y + 1, _z + 1, PX, w, 0, 1));
+          pushVertex(vertices, l, packVertex(_x + 1, _y, _z, PX, w, 1, 0));
+          pushVertex(vertices, l, packVertex(_x + 1, _y + 1, _z + 1, PX, w, 0, 1));
+          pushVertex(vertices, l, packVertex(_x + 1, _y, _z + 1, PX, w, 0, 0));
+          pushVertex(vertices, l, packVertex(_x + 1, _y, _z, PX, w, 1, 0));
+          pushVertex(vertices, l, packVertex(_x + 1, _y + 1, _z, PX, w, 1, 1));
+          pushVertex(vertices, l, packVertex(_x + 1, _y + 1, _z + 1, PX, w, 0, 1));
         }
 
         // add a face if -z is transparent
         if(isTransparent(get(_x, _y, _z - 1, px, nx, py, ny, pz, nz))) {
+          l = getLight(_x, _y, _z - 1, px, nx, py, ny, pz, nz);
           w = BLOCKS[block][4]; // get texture coordinates
 
-          vertexData.push_back(packVertex(_x, _y, _z, NZ, w, 0, 0));
-          vertexData.push_back(packVertex(_x + 1, _y + 1, _z, NZ, w, 1, 1));
-          vertexData.push_back(packVertex(_x + 1, _y, _z, NZ, w, 1, 0));
-          vertexData.push_back(packVertex(_x, _y, _z, NZ, w, 0, 0));
-          vertexData.push_back(packVertex(_x, _y + 1, _z, NZ, w, 0, 1));
-          vertexData.push_back(packVertex(_x + 1, _y + 1, _z, NZ, w, 1, 1));
+          pushVertex(vertices, l, packVertex(_x, _y, _z, NZ, w, 0, 0));
+          pushVertex(vertices, l, packVertex(_x + 1, _y + 1, _z, NZ, w, 1, 1));
+          pushVertex(vertices, l, packVertex(_x + 1, _y, _z, NZ, w, 1, 0));
+          pushVertex(vertices, l, packVertex(_x, _y, _z, NZ, w, 0, 0));
+          pushVertex(vertices, l, packVertex(_x, _y + 1, _z, NZ, w, 0, 1));
+          pushVertex(vertices, l, packVertex(_x + 1, _y + 1, _z, NZ, w, 1, 1));
         }
 
         // add a face if +z is transparent
         if(isTransparent(get(_x, _y, _z + 1, px, nx, py, ny, pz, nz))) {
+          l = getLight(_x, _y, _z + 1, px, nx, py, ny, pz, nz);
           w = BLOCKS[block][5]; // get texture coordinates
 
-          vertexData.push_back(packVertex(_x, _y, _z + 1, PZ, w, 0, 0));
-          vertexData.push_back(packVertex(_x + 1, _y, _z + 1, PZ, w, 1, 0));
-          vertexData.push_back(packVertex(_x + 1, _y + 1, _z + 1, PZ, w, 1, 1));
-          vertexData.push_back(packVertex(_x, _y, _z + 1, PZ, w, 0, 0));
-          vertexData.push_back(packVertex(_x + 1, _y + 1, _z + 1, PZ, w, 1, 1));
-          vertexData.push_back(packVertex(_x, _y + 1, _z + 1, PZ, w, 0, 1));
+          pushVertex(vertices, l, packVertex(_x, _y, _z + 1, PZ, w, 0, 0));
+          pushVertex(vertices, l, packVertex(_x + 1, _y, _z + 1, PZ, w, 1, 0));
+          pushVertex(vertices, l, packVertex(_x + 1, _y + 1, _z + 1, PZ, w, 1, 1));
+          pushVertex(vertices, l, packVertex(_x, _y, _z + 1, PZ, w, 0, 0));
+          pushVertex(vertices, l, packVertex(_x + 1, _y + 1, _z + 1, PZ, w, 1, 1));
+          pushVertex(vertices, l, packVertex(_x, _y + 1, _z + 1, PZ, w, 0, 1));
         }
 
         // add a face if -y is transparent
         if(isTransparent(get(_x, _y - 1, _z, px, nx, py, ny, pz, nz))) {
+          l = getLight(_x, _y - 1, _z, px, nx, py, ny, pz, nz);
           w = BLOCKS[block][3]; // get texture coordinates
 
-          vertexData.push_back(packVertex(_x, _y, _z, NY, w, 0, 0));
-          vertexData.push_back(packVertex(_x + 1, _y, _z, NY, w, 1, 0));
-          vertexData.push_back(packVertex(_x + 1, _y, _z + 1, NY, w, 1, 1));
-          vertexData.push_back(packVertex(_x, _y, _z, NY, w, 0, 0));
-          vertexData.push_back(packVertex(_x + 1, _y, _z + 1, NY, w, 1, 1));
-          vertexData.push_back(packVertex(_x, _y, _z + 1, NY, w, 0, 1));
+          pushVertex(vertices, l, packVertex(_x, _y, _z, NY, w, 0, 0));
+          pushVertex(vertices, l, packVertex(_x + 1, _y, _z, NY, w, 1, 0));
+          pushVertex(vertices, l, packVertex(_x + 1, _y, _z + 1, NY, w, 1, 1));
+          pushVertex(vertices, l, packVertex(_x, _y, _z, NY, w, 0, 0));
+          pushVertex(vertices, l, packVertex(_x + 1, _y, _z + 1, NY, w, 1, 1));
+          pushVertex(vertices, l, packVertex(_x, _y, _z + 1, NY, w, 0, 1));
         }
 
         // add a face if +y is transparent
         if(isTransparent(get(_x, _y + 1, _z, px, nx, py, ny, pz, nz))) {
+          l = getLight(_x, _y + 1, _z, px, nx, py, ny, pz, nz);
           w = BLOCKS[block][2]; // get texture coordinates
 
-          vertexData.push_back(packVertex(_x, _y + 1, _z, PY, w, 0, 1));
-          vertexData.push_back(packVertex(_x, _y + 1, _z + 1, PY, w, 0, 0));
-          vertexData.push_back(packVertex(_x + 1, _y + 1, _z + 1, PY, w, 1, 0));
-          vertexData.push_back(packVertex(_x, _y + 1, _z, PY, w, 0, 1));
-          vertexData.push_back(packVertex(_x + 1, _y + 1, _z + 1, PY, w, 1, 0));
-          vertexData.push_back(packVertex(_x + 1, _y + 1, _z, PY, w, 1, 1));
+          pushVertex(vertices, l, packVertex(_x, _y + 1, _z, PY, w, 0, 1));
+          pushVertex(vertices, l, packVertex(_x, _y + 1, _z + 1, PY, w, 0, 0));
+          pushVertex(vertices, l, packVertex(_x + 1, _y + 1, _z + 1, PY, w, 1, 0));
+          pushVertex(vertices, l, packVertex(_x, _y + 1, _z, PY, w, 0, 1));
+          pushVertex(vertices, l, packVertex(_x + 1, _y + 1, _z + 1, PY, w, 1, 0));
+          pushVertex(vertices, l, packVertex(_x + 1, _y + 1, _z, PY, w, 1, 1));
         }
       }
     }
   }
 
-  elements = (uint)vertexData.size(); // set number of vertices
-  meshChanged = true;
+  elements = (uint)vertices.size() / 2; // set number of vertices
 
-#ifdef PRINT_TIMING
-  printf("created chunk with %d vertices: ", elements);
-#endif
+  // hand the exact sized mesh over to the renderer through the frame arena
+  if(elements > 0) {
+    vertexData = FrameArena::allocate<int>(vertices.size());
+    memcpy(vertexData, vertices.data(), vertices.size() * sizeof(int));
+  } else {
+    vertexData = nullptr;
+  }
+
+  meshChanged = true;
 
   return true;
 }
 
-void Chunk::draw() {
-  bufferMesh();
+// int coordinates so -1 reaches into the negative neighbors
+inline block_t Chunk::get(int _x, int _y, int _z, const std::shared_ptr<Chunk>& px, const std::shared_ptr<Chunk>& nx, const std::shared_ptr<Chunk>& py, const std::shared_ptr<Chunk>& ny,
+                          const std::shared_ptr<Chunk>& pz, const std::shared_ptr<Chunk>& nz) {
+  return neighborAt(_x, _y, _z, px, nx, py, ny, pz, nz)->blocks[blockIndex(_x & (CHUNK_SIZE - 1), _y & (CHUNK_SIZE - 1), _z & (CHUNK_SIZE - 1))];
+}
 
-  vao->bind();
-  GL::drawArrays(elements);
+inline uint8_t Chunk::getLight(int _x, int _y, int _z, const std::shared_ptr<Chunk>& px, const std::shared_ptr<Chunk>& nx, const std::shared_ptr<Chunk>& py, const std::shared_ptr<Chunk>& ny,
+                               const std::shared_ptr<Chunk>& pz, const std::shared_ptr<Chunk>& nz) {
+  return neighborAt(_x, _y, _z, px, nx, py, ny, pz, nz)->light[blockIndex(_x & (CHUNK_SIZE - 1), _y & (CHUNK_SIZE - 1), _z & (CHUNK_SIZE - 1))];
 }
 
-// if the chunk's mesh has been modified then send the new data to opengl (TODO: don't create a new buffer, just reuse the old one)
-void Chunk::bufferMesh() {
-  // if the mesh has not been modified then don't bother
-  if(!meshChanged) {
-    return;
+// the chunk holding a block at most one step outside this one
+inline Chunk* Chunk::neighborAt(int _x, int _y, int _z, const std::shared_ptr<Chunk>& px, const std::shared_ptr<Chunk>& nx, const std::shared_ptr<Chunk>& py, const std::shared_ptr<Chunk>& ny,
+                                const std::shared_ptr<Chunk>& pz, const std::shared_ptr<Chunk>& nz) {
+  if(_x < 0) { // -x neighbor
+    return nx.get();
   }
 
-#ifdef PRINT_TIMING
-  Timer timer;
-#endif
+  if(_x >= CHUNK_SIZE) { // +x neighbor
+    return px.get();
+  }
 
-  if(vao == nullptr) {
-    vao = new GL::VAO();
+  if(_y < 0) { // -y neighbor
+    return ny.get();
   }
 
-  GL::Buffer<GL::ARRAY>* vbo = new GL::Buffer<GL::ARRAY>();
+  if(_y >= CHUNK_SIZE) { // +y neighbor
+    return py.get();
+  }
 
-  vao->bind();
+  if(_z < 0) { // -z neighbor
+    return nz.get();
+  }
 
-  vbo->data(elements * sizeof(int), vertexData.data());
-  vao->attribI(0, 1, GL::INT);
+  if(_z >= CHUNK_SIZE) { // +z neighbor
+    return pz.get();
+  }
 
-  GL::VAO::unbind();
-  delete vbo;
+  return this;
+}
 
-  vertexData.clear();
-  vertexData.shrink_to_fit();
+block_t Chunk::get(uint8_t _x, uint8_t _y, uint8_t _z) {
+  return blocks[blockIndex(_x, _y, _z)];
+}
 
-  meshChanged = false;
+void Chunk::set(uint8_t _x, uint8_t _y, uint8_t _z, block_t block) {
+  block_t& current = blocks[blockIndex(_x, _y, _z)];
 
-#ifdef PRINT_TIMING
-  printf("buffered chunk mesh: %zuB ", elements * sizeof(int));
-#endif
-}
+  tickableCount += (isRandomTickable(block) ? 1 : 0) - (isRandomTickable(current) ? 1 : 0);
+  current = block;
 
-inline block_t Chunk::get(uint8_t _x, uint8_t _y, uint8_t _z, const std::shared_ptr<Chunk>& px, const std::shared_ptr<Chunk>& nx, const std::shared_ptr<Chunk>& py, const std::shared_ptr<Chunk>& ny,
-                          const std::shared_ptr<Chunk>& pz, const std::shared_ptr<Chunk>& nz) {
-  if(_x < 0) { // gets block from -x neighbor
-    return nx->blocks[blockIndex(CHUNK_SIZE + _x, _y, _z)];
+  if(block != AIR) {
+    occupancy |= 1ull << regionBit(_x, _y, _z);
+  } else {
+    updateRegion(_x, _y, _z);
   }
 
-  if(_x >= CHUNK_SIZE) { // gets block from +x neighbor
-    return px->blocks[blockIndex(_x % CHUNK_SIZE, _y, _z)];
-  }
+  empty = occupancy == 0;
+  changed = true;
+}
 
-  if(_y < 0) { // gets block from -y neighbor
-    return ny->blocks[blockIndex(_x, CHUNK_SIZE + _y, _z)];
-  }
+// rebuilds the occupancy after writes through getBlocks and marks the chunk for remeshing
+void Chunk::blocksChanged() {
+  occupancy = computeOccupancy(blocks);
+  empty = occupancy == 0;
+  changed = true;
 
-  if(_y >= CHUNK_SIZE) { // gets block from +y neighbor
-    return py->blocks[blockIndex(_x, _y % CHUNK_SIZE, _z)];
-  }
+  countTickable();
+}
 
-  if(_z < 0) { // gets block from -z neighbor
-    return nz->blocks[blockIndex(_x, _y, CHUNK_SIZE + _z)];
-  }
+// full recount, regions that only hold air are skipped
+void Chunk::countTickable() {
+  tickableCount = 0;
 
-  if(_z >= CHUNK_SIZE) { // gets block from +z neighbor
-    return pz->blocks[blockIndex(_x, _y, _z % CHUNK_SIZE)];
-  }
+  for(uint i = 0; i < CHUNK_SIZE_CUBED; i += CHUNK_REGION_SIZE) {
+    if(isRegionEmpty(i & (CHUNK_SIZE - 1), (i >> 5) & (CHUNK_SIZE - 1), i >> 10)) {
+      continue;
+    }
 
-  return blocks[blockIndex(_x, _y, _z)];
+    for(uint j = i; j < i + CHUNK_REGION_SIZE; j++) {
+      tickableCount += isRandomTickable(blocks[j]) ? 1 : 0;
+    }
+  }
 }
 
-block_t Chunk::get(uint8_t _x, uint8_t _y, uint8_t _z) {
-  return blocks[blockIndex(_x, _y, _z)];
-}
+// rescan the region holding the block, clearing its bit once it only holds air
+void Chunk::updateRegion(uint8_t _x, uint8_t _y, uint8_t _z) {
+  const uint8_t rx = _x & ~(CHUNK_REGION_SIZE - 1);
+  const uint8_t ry = _y & ~(CHUNK_REGION_SIZE - 1);
+  const uint8_t rz = _z & ~(CHUNK_REGION_SIZE - 1);
+
+  for(uint8_t dz = rz; dz < rz + CHUNK_REGION_SIZE; dz++) {
+    for(uint8_t dy = ry; dy < ry + CHUNK_REGION_SIZE; dy++) {
+      for(uint8_t dx = rx; dx < rx + CHUNK_REGION_SIZE; dx++) {
+        if(blocks[blockIndex(dx, dy, dz)] != AIR) {
+          return;
+        }
+      }
+    }
+  }
 
-void Chunk::set(uint8_t _x, uint8_t _y, uint8_t _z, block_t block) {
-  blocks[blockIndex(_x, _y, _z)] = block;
-  changed = true;
+  occupancy &= ~(1ull << regionBit(_x, _y, _z));
 }
@@ -1,42 +1,106 @@
 #include "chunk_manager.h"
 
-#include "timer.h"
+#include <stdio.h>
+#include <set>
+#include <algorithm>
+#include <thread>
 
-/**
-  * @brief Checks if the given chunk matrix is visible
-  * @return bool Chunk visible
-*/
-inline bool isChunkInsideFrustum(glm::mat4 mvp) {
-  glm::vec4 center = mvp * glm::vec4(CHUNK_SIZE / 2, CHUNK_SIZE / 2, CHUNK_SIZE / 2, 1);
-  center.x /= center.w;
-  center.y /= center.w;
+#include "profiler.h"
+#include "terrain.h"
+#include "world_storage.h"
+#include "lighting.h"
+#include "block_ticks.h"
+#include "chunk_stream.h"
+#include "world.h"
 
-  return !(center.z < -CHUNK_SIZE / 2 || fabsf(center.x) > 1 + fabsf(CHUNK_SIZE * 2 / center.w) || fabsf(center.y) > 1 + fabsf(CHUNK_SIZE * 2 / center.w));
+inline int distanceSquared(const vec3i& a, const vec3i& b) {
+  return (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z);
 }
 
+// most chunks taken from the terrain workers or loaded from disk per update
+const uint MAX_CHUNKS_ADDED_PER_UPDATE = 50;
+
 namespace ChunkManager {
 chunk_map chunks;
 vec3i cameraPos;
 
-GL::Shader* shader;
-int shaderProjectionLocation, shaderViewLocation, shaderModelLocation;
+// chunks handed to the terrain pipeline and not collected yet
+std::set<vec3i> requested;
+std::vector<Terrain::generated_chunk_t> generatedChunks;
+std::vector<vec3i> missing;
+std::vector<vec3i> relit;
+std::vector<World::block_edit_t> deltas;
+
+/*
+  chebyshev radii around the camera chunk. every chunk out to requestedRadius
+  is loaded or requested, every chunk out to loadedRadius is loaded. only the
+  shells past them are scanned, -1 means not even the camera chunk
+*/
+int requestedRadius = -1;
+int loadedRadius = -1;
+
+// chunks come from the world server, until the connection is lost
+bool streaming = false;
 }
 
-void ChunkManager::init() {
-  shader = new GL::Shader(GL::Shaders::chunk);
-  shader->use();
+void ChunkManager::free() {
+  Terrain::free();
+  Lighting::free();
+  // the chunks hand their storage back to the pools, which must still exist then
+  chunks.clear();
+  requested.clear();
+  requestedRadius = loadedRadius = -1;
+}
 
-  shader->setInt("texture_array", 0);
-  shader->setInt("fog_near", viewDistance * CHUNK_SIZE - CHUNK_SIZE / 2);
-  shader->setInt("fog_far", viewDistance * CHUNK_SIZE);
+// the chunk is drawn once the lighting worker has lit it
+static void addChunk(vec3i pos, block_t* blocks, uint64_t occupancy) {
+  std::shared_ptr<Chunk> chunk = std::make_shared<Chunk>(pos.x, pos.y, pos.z, blocks, occupancy);
 
-  shaderProjectionLocation = shader->getUniformLocation("projection");
-  shaderViewLocation = shader->getUniformLocation("view");
-  shaderModelLocation = shader->getUniformLocation("model");
+  ChunkManager::chunks.insert(std::make_pair(pos, chunk));
+  Lighting::addChunk(chunk.get());
+  BlockTicks::chunkChanged(pos);
 }
 
-void ChunkManager::free() {
-  delete shader;
+// drops terrain work further than distance chunks from center
+static void pruneRequests(vec3i center, int distance) {
+  using namespace ChunkManager;
+
+  if(ChunkStream::isConnected()) {
+    ChunkStream::prune(center, distance);
+  } else {
+    Terrain::prune(center, distance);
+  }
+
+  for(std::set<vec3i>::iterator it = requested.begin(); it != requested.end();) {
+    if(abs(it->x - center.x) > distance || abs(it->y - center.y) > distance || abs(it->z - center.z) > distance) {
+      it = requested.erase(it);
+    } else {
+      it++;
+    }
+  }
+}
+
+void ChunkManager::setViewDistance(int distance) {
+  viewDistance = MAX(distance, 1);
+
+  // growing only scans the new shells
+  requestedRadius = MIN(requestedRadius, viewDistance + 1);
+  loadedRadius = MIN(loadedRadius, viewDistance + 1);
+
+  // loaded chunks outside are unloaded by update within the per-frame budget
+  pruneRequests(cameraPos, viewDistance + 1);
+}
+
+int ChunkManager::getViewDistance() {
+  return viewDistance;
+}
+
+int ChunkManager::getLoadedRadius() {
+  return loadedRadius;
+}
+
+vec3i ChunkManager::getCameraChunk() {
+  return cameraPos;
 }
 
 std::shared_ptr<Chunk> ChunkManager::get(vec3i pos) {
@@ -49,87 +113,217 @@ std::shared_ptr<Chunk> ChunkManager::get(vec3i pos) {
   return nullptr;
 }
 
-void ChunkManager::update(vec3i camPos) {
-  const int distance = viewDistance + 1;
-  cameraPos = camPos;
-  vec3i chunkPos;
-  uint8_t generated = 0;
-
-  for(int i = -distance; i <= distance; i++) {
-    for(int j = -distance; j <= distance; j++) {
-      for(int k = -distance; k <= distance; k++) {
-        chunkPos.x = cameraPos.x + i;
-        chunkPos.y = cameraPos.y + k;
-        chunkPos.z = cameraPos.z + j;
-
-        if(!get(chunkPos)) {
-          chunks.insert(std::make_pair(chunkPos, std::make_shared<Chunk>(chunkPos.x, chunkPos.y, chunkPos.z)));
-
-          if(++generated == 50) {
-            return;
-          }
+/**
+  * @brief Calls func for every position on the surface of the cube of the given radius around center
+  * @return bool False if func stopped the walk
+*/
+template<typename F>
+static bool forEachInShell(vec3i center, int radius, F func) {
+  vec3i pos;
+
+  for(int i = -radius; i <= radius; i++) {
+    for(int j = -radius; j <= radius; j++) {
+      bool edge = abs(i) == radius || abs(j) == radius;
+
+      // inside the shell only the two faces along the last axis are visited
+      for(int k = -radius; k <= radius; k += edge || radius == 0 ? 1 : radius * 2) {
+        pos.x = center.x + i;
+        pos.y = center.y + k;
+        pos.z = center.z + j;
+
+        if(!func(pos)) {
+          return false;
         }
       }
     }
   }
+
+  return true;
 }
 
-void ChunkManager::draw(glm::mat4 projection, glm::mat4 view) {
-  shader->use();
-  shader->setMat4(shaderProjectionLocation, projection);
-  shader->setMat4(shaderViewLocation, view);
+// loads or requests the chunks past requestedRadius, added counts the chunks this update already took
+static void requestMissing(uint added) {
+  using namespace ChunkManager;
 
-  uint chunksDeleted = 0;
-  uint chunksGenerated = 0;
-  int dx, dy, dz;
+  const int distance = viewDistance + 1;
 
-  glm::mat4 pv = projection * view;
+  // walk outward shell by shell, a shell cut short by the disk budget is rescanned next update
+  while(requestedRadius < distance) {
+    bool complete = forEachInShell(cameraPos, requestedRadius + 1, [&added](const vec3i & chunkPos) {
+      if(get(chunkPos) || requested.count(chunkPos) > 0) {
+        return true;
+      }
 
-#ifdef PRINT_TIMING
-  Timer timer;
-#endif
+      // pregenerated chunks come from disk, everything else from the server or the terrain pipeline
+      if(WorldStorage::isOpen() && !ChunkStream::isConnected()) {
+        if(added >= MAX_CHUNKS_ADDED_PER_UPDATE) {
+          return false;
+        }
 
-  for(chunk_it it = ChunkManager::chunks.begin(); it != ChunkManager::chunks.end(); it++) {
-    std::shared_ptr<Chunk> chunk = it->second;
+        block_t* blocks = (block_t*)Chunk::blockPool.allocate();
 
-    dx = cameraPos.x - chunk->x;
-    dy = cameraPos.y - chunk->y;
-    dz = cameraPos.z - chunk->z;
+        if(WorldStorage::loadChunk(chunkPos.x, chunkPos.y, chunkPos.z, blocks)) {
+          addChunk(chunkPos, blocks, computeOccupancy(blocks));
+          added++;
+          return true;
+        }
 
-    // don't render chunks outside of generation radius
-    if(abs(dx) > viewDistance + 1 || abs(dy) > viewDistance + 1 || abs(dz) > viewDistance + 1) {
-      if(chunksDeleted < (uint)maxChunksDeletedPerFrame) {
-        STACK_TRACE_PUSH("remove chunk")
-        it = ChunkManager::chunks.erase(it);
-        chunk.reset();
-        chunksDeleted++;
+        Chunk::blockPool.release(blocks);
       }
 
-      continue;
+      missing.push_back(chunkPos);
+      return true;
+    });
+
+    if(!complete) {
+      break;
     }
 
-    // don't render invisible chunks
-    if(chunk->empty || abs(dx) > viewDistance || abs(dy) > viewDistance || abs(dz) > viewDistance || !isChunkInsideFrustum(pv * chunk->model)) {
-      continue;
+    requestedRadius++;
+  }
+
+  // workers take requests in order, so the closest chunks are generated first
+  std::sort(missing.begin(), missing.end(), [](const vec3i & a, const vec3i & b) {
+    return distanceSquared(a, cameraPos) < distanceSquared(b, cameraPos);
+  });
+
+  for(const vec3i& pos : missing) {
+    if(ChunkStream::isConnected()) {
+      ChunkStream::request(pos);
+    } else {
+      Terrain::request(pos);
     }
 
-    // update chunk if needed
-    if(chunk->changed && chunksGenerated < (uint)maxChunksGeneratedPerFrame) {
-      if(chunk->update() && chunk->elements > 0) {
-        chunksGenerated++;
-      }
+    requested.insert(pos);
+  }
+
+  missing.clear();
+}
+
+// leave a core for the render thread
+static void startTerrain() {
+  Terrain::init(MAX(std::thread::hardware_concurrency(), 2u) - 1, &Chunk::blockPool);
+}
+
+void ChunkManager::prepare(vec3i camPos) {
+  Chunk::blockPool.setHugePages(hugePages);
+  Chunk::lightPool.setHugePages(hugePages);
+
+  // a streaming client generates nothing itself
+  streaming = ChunkStream::isConnected();
+
+  if(!streaming) {
+    startTerrain();
+  }
+
+  Lighting::init();
+
+  cameraPos = camPos;
+
+  // the server only generates around the areas its clients announced
+  if(streaming) {
+    ChunkStream::prune(cameraPos, viewDistance + 1);
+  }
+
+  requestMissing(0);
+}
+
+void ChunkManager::update(vec3i camPos) {
+  PROFILE_SCOPE("chunk load")
+
+  const int distance = viewDistance + 1;
+  uint added = 0;
+
+  // the camera moved to another chunk, stop generating what is now out of range
+  if(camPos != cameraPos) {
+    int moved = MAX(abs(camPos.x - cameraPos.x), MAX(abs(camPos.y - cameraPos.y), abs(camPos.z - cameraPos.z)));
+
+    // the cubes around the old position still cover this much around the new one
+    requestedRadius = MAX(requestedRadius - moved, -1);
+    loadedRadius = MAX(loadedRadius - moved, -1);
+
+    pruneRequests(camPos, distance);
+  }
+
+  cameraPos = camPos;
+
+  if(streaming) {
+    ChunkStream::collect(generatedChunks, MAX_CHUNKS_ADDED_PER_UPDATE, &Chunk::blockPool);
+
+    // the server went away, everything it still owed is generated here from the same seed
+    if(!ChunkStream::isConnected()) {
+      printf("generating the world locally, edits from other players stop arriving\n");
+
+      streaming = false;
+      startTerrain();
+      requested.clear();
+      requestedRadius = loadedRadius = -1;
     }
+  } else {
+    Terrain::collect(generatedChunks, MAX_CHUNKS_ADDED_PER_UPDATE);
+  }
 
-    // don't draw if chunk has no mesh
-    if(chunk->elements == 0) {
+  for(const Terrain::generated_chunk_t& generated : generatedChunks) {
+    requested.erase(generated.pos);
+
+    if(abs(generated.pos.x - cameraPos.x) > distance || abs(generated.pos.y - cameraPos.y) > distance || abs(generated.pos.z - cameraPos.z) > distance) {
+      Chunk::blockPool.release(generated.blocks);
       continue;
     }
 
-    ChunkManager::shader->setMat4(shaderModelLocation, chunk->model);
-    chunk->draw();
+    addChunk(generated.pos, generated.blocks, generated.occupancy);
+    added++;
+  }
+
+  generatedChunks.clear();
+
+  // edits made by other clients of the server, chunks that aren't loaded get them with their blocks later
+  ChunkStream::collectDeltas(deltas);
+
+  if(!deltas.empty()) {
+    World::setBlocks(deltas);
+    deltas.clear();
+  }
+
+  Lighting::collect(relit);
+
+  for(const vec3i& pos : relit) {
+    std::shared_ptr<Chunk> chunk = get(pos);
+
+    if(chunk != nullptr) {
+      chunk->lit = true;
+      chunk->changed = !chunk->empty;
+    }
+  }
+
+  relit.clear();
+
+  requestMissing(added);
+
+  // stops at the first chunk still missing, so a filled radius costs one shell check
+  while(loadedRadius < requestedRadius) {
+    bool loaded = forEachInShell(cameraPos, loadedRadius + 1, [](const vec3i & chunkPos) {
+      return chunks.count(chunkPos) > 0;
+    });
+
+    if(!loaded) {
+      break;
+    }
+
+    loadedRadius++;
   }
 
-#ifdef PRINT_TIMING
-  printf("draw all chunks: ");
-#endif
+  uint chunksDeleted = 0;
+
+  // unload chunks outside of the generation radius
+  for(chunk_it it = chunks.begin(); it != chunks.end() && chunksDeleted < (uint)maxChunksDeletedPerFrame;) {
+    if(abs(it->first.x - cameraPos.x) > distance || abs(it->first.y - cameraPos.y) > distance || abs(it->first.z - cameraPos.z) > distance) {
+      STACK_TRACE_PUSH("remove chunk")
+      Lighting::removeChunk(it->first);
+      it = chunks.erase(it);
+      chunksDeleted++;
+    } else {
+      it++;
+    }
+  }
 }
@@ -0,0 +1,260 @@
+#include "chunk_renderer.h"
+
+#include <map>
+#include <memory>
+#include <string.h>
+#include <math.h>
+
+#include "gl/utils.h"
+#include "gl/vao.h"
+#include "gl/buffer.h"
+#include "gl/stream_buffer.h"
+
+#include "chunk_manager.h"
+#include "memory_tracker.h"
+#include "profiler.h"
+
+/**
+  * @brief Checks if the given chunk matrix is visible
+  * @return bool Chunk visible
+*/
+inline bool isChunkInsideFrustum(glm::mat4 mvp) {
+  glm::vec4 center = mvp * glm::vec4(CHUNK_SIZE / 2, CHUNK_SIZE / 2, CHUNK_SIZE / 2, 1);
+  center.x /= center.w;
+  center.y /= center.w;
+
+  return !(center.z < -CHUNK_SIZE / 2 || fabsf(center.x) > 1 + fabsf(CHUNK_SIZE * 2 / center.w) || fabsf(center.y) > 1 + fabsf(CHUNK_SIZE * 2 / center.w));
+}
+
+// bytes of new meshes staged per frame, meshes that don't fit are uploaded directly
+const size_t MESH_STREAM_REGION_SIZE = 4 * 1024 * 1024;
+
+// fraction of the gap to the loaded radius the fog closes per frame
+const float FOG_EASE = 0.05f;
+
+// gpu side of a chunk's mesh, chunk tells a reloaded chunk at the same position apart
+struct chunk_mesh_t {
+  std::weak_ptr<Chunk> chunk;
+  GL::VAO* vao;
+  GL::Buffer<GL::ARRAY>* vbo;
+  uint elements;
+};
+
+namespace ChunkRenderer {
+// same order as ChunkManager::chunks, so both are walked side by side
+std::map<vec3i, chunk_mesh_t> meshes;
+
+// staging for new meshes, copied into the chunk buffers on the gpu
+GL::StreamBuffer* meshStream;
+
+// in chunks, eases out to the loaded radius as it fills in
+float fogDistance = 0.0f;
+
+// visible chunks the last draw left unlit or unmeshed
+uint pendingChunks = 0;
+
+GL::Shader* shader;
+int shaderProjectionLocation, shaderViewLocation, shaderModelLocation;
+int shaderFogNearLocation, shaderFogFarLocation;
+}
+
+static void setFog(float distance) {
+  using namespace ChunkRenderer;
+
+  fogDistance = distance;
+
+  shader->use();
+  shader->setFloat(shaderFogNearLocation, fogDistance * CHUNK_SIZE - CHUNK_SIZE / 2);
+  shader->setFloat(shaderFogFarLocation, fogDistance * CHUNK_SIZE);
+}
+
+static void deleteMesh(chunk_mesh_t& mesh) {
+  delete mesh.vao;
+  delete mesh.vbo;
+}
+
+// sends the chunk's new mesh to opengl, the old one stays alive until the gpu is done drawing it
+static void uploadMesh(chunk_mesh_t& mesh, const std::shared_ptr<Chunk>& chunk) {
+  using namespace ChunkRenderer;
+
+  PROFILE_SCOPE("chunk upload")
+  MEMORY_TAG(MemoryTracker::GL_WRAPPERS)
+
+  mesh.elements = chunk->elements;
+
+  if(mesh.elements == 0) {
+    return;
+  }
+
+  size_t size = mesh.elements * 2 * sizeof(int);
+
+  if(mesh.vao == nullptr) {
+    mesh.vao = new GL::VAO();
+    mesh.vbo = new GL::Buffer<GL::ARRAY>();
+
+    mesh.vao->bind();
+    mesh.vbo->bind();
+    mesh.vao->attribI(0, 2, GL::INT);
+    GL::VAO::unbind();
+  }
+
+  void* staging = meshStream->map(size);
+
+  if(staging != nullptr) {
+    mesh.vbo->data(size, NULL);
+    memcpy(staging, chunk->getMesh(), size);
+    GL::copyBuffer(meshStream->getHandle(), meshStream->commit(), mesh.vbo->getHandle(), 0, size);
+  } else {
+    mesh.vbo->data(size, chunk->getMesh());
+  }
+
+  GL::Buffer<GL::ARRAY>::unbind();
+}
+
+static void loadShader() {
+  using namespace ChunkRenderer;
+
+  shader = new GL::Shader("chunk");
+  shader->use();
+
+  shader->setInt("texture_array", 0);
+
+  shaderProjectionLocation = shader->getUniformLocation("projection");
+  shaderViewLocation = shader->getUniformLocation("view");
+  shaderModelLocation = shader->getUniformLocation("model");
+  shaderFogNearLocation = shader->getUniformLocation("fog_near");
+  shaderFogFarLocation = shader->getUniformLocation("fog_far");
+}
+
+void ChunkRenderer::init() {
+  loadShader();
+  setFog(1.0f);
+
+  meshStream = new GL::StreamBuffer(MESH_STREAM_REGION_SIZE);
+}
+
+void ChunkRenderer::free() {
+  for(std::pair<const vec3i, chunk_mesh_t>& entry : meshes) {
+    deleteMesh(entry.second);
+  }
+
+  meshes.clear();
+
+  delete meshStream;
+  delete shader;
+}
+
+void ChunkRenderer::reloadShader() {
+  delete shader;
+  loadShader();
+  setFog(fogDistance);
+}
+
+bool ChunkRenderer::isViewComplete() {
+  return ChunkManager::getLoadedRadius() >= viewDistance && pendingChunks == 0;
+}
+
+void ChunkRenderer::draw(glm::mat4 projection, glm::mat4 view) {
+  PROFILE_SCOPE("chunk draw")
+
+  float fogTarget = (float)MAX(MIN(ChunkManager::getLoadedRadius(), viewDistance), 1);
+
+  // a shrunk view distance pulls the fog in at once
+  if(fogDistance > viewDistance) {
+    setFog((float)viewDistance);
+  } else if(fabsf(fogTarget - fogDistance) > 0.01f) {
+    setFog(fogDistance + (fogTarget - fogDistance) * FOG_EASE);
+  }
+
+  shader->use();
+  shader->setMat4(shaderProjectionLocation, projection);
+  shader->setMat4(shaderViewLocation, view);
+
+  uint chunksGenerated = 0;
+  int dx, dy, dz;
+
+  pendingChunks = 0;
+
+  glm::mat4 pv = projection * view;
+  vec3i cameraChunk = ChunkManager::getCameraChunk();
+
+  std::map<vec3i, chunk_mesh_t>::iterator mesh = meshes.begin();
+
+  for(chunk_it it = ChunkManager::chunks.begin(); it != ChunkManager::chunks.end(); it++) {
+    const std::shared_ptr<Chunk>& chunk = it->second;
+
+    // meshes ordered before this chunk belong to unloaded chunks
+    while(mesh != meshes.end() && mesh->first < it->first) {
+      deleteMesh(mesh->second);
+      mesh = meshes.erase(mesh);
+    }
+
+    bool hasMesh = mesh != meshes.end() && mesh->first == it->first;
+
+    // the chunk was unloaded and loaded again, its old mesh is stale
+    if(hasMesh && mesh->second.chunk.lock() != chunk) {
+      mesh->second.elements = 0;
+      mesh->second.chunk = chunk;
+    }
+
+    dx = cameraChunk.x - chunk->x;
+    dy = cameraChunk.y - chunk->y;
+    dz = cameraChunk.z - chunk->z;
+
+    // don't render invisible chunks
+    if(chunk->empty || abs(dx) > viewDistance || abs(dy) > viewDistance || abs(dz) > viewDistance || !isChunkInsideFrustum(pv * chunk->model)) {
+      if(hasMesh) {
+        mesh++;
+      }
+
+      continue;
+    }
+
+    // update chunk if needed
+    if(chunk->changed && chunksGenerated < (uint)maxChunksGeneratedPerFrame) {
+      if(chunk->update() && chunk->elements > 0) {
+        chunksGenerated++;
+      }
+    }
+
+    // still waiting on the lighting worker, its neighbors or the meshing budget
+    if(chunk->changed) {
+      pendingChunks++;
+    }
+
+    // the mesh lives in the frame arena, it has to be taken this frame
+    if(chunk->hasNewMesh()) {
+      if(!hasMesh) {
+        mesh = meshes.insert(mesh, std::make_pair(it->first, chunk_mesh_t{chunk, nullptr, nullptr, 0}));
+        hasMesh = true;
+      }
+
+      uploadMesh(mesh->second, chunk);
+      chunk->meshTaken();
+    }
+
+    if(!hasMesh) {
+      continue;
+    }
+
+    chunk_mesh_t& current = mesh->second;
+    mesh++;
+
+    // don't draw if chunk has no mesh
+    if(current.elements == 0) {
+      continue;
+    }
+
+    shader->setMat4(shaderModelLocation, chunk->model);
+    current.vao->bind();
+    GL::drawArrays(current.elements);
+  }
+
+  // everything past the last chunk was unloaded
+  while(mesh != meshes.end()) {
+    deleteMesh(mesh->second);
+    mesh = meshes.erase(mesh);
+  }
+
+  meshStream->endFrame();
+}
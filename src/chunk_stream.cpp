@@ -0,0 +1,216 @@
+#include "chunk_stream.h"
+
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+#include <deque>
+
+#include "net.h"
+#include "world_storage.h"
+
+// how long connect waits for the server's hello
+const double HELLO_TIMEOUT = 5.0; // seconds
+
+namespace ChunkStream {
+Net::Connection* connection = nullptr;
+uint seed = 0;
+
+// decoded chunks not collected yet, their blocks come from pool
+std::deque<Terrain::generated_chunk_t> received;
+SlabPool* pool = nullptr;
+std::vector<World::block_edit_t> deltas;
+}
+
+inline vec3i readPos(const uint8_t* data) {
+  return {(int)Net::getU32(data), (int)Net::getU32(data + 4), (int)Net::getU32(data + 8)};
+}
+
+inline void writePos(uint8_t* data, vec3i pos) {
+  Net::putU32(data, (uint)pos.x);
+  Net::putU32(data + 4, (uint)pos.y);
+  Net::putU32(data + 8, (uint)pos.z);
+}
+
+// a delta for a chunk that arrived but isn't collected yet is written into its blocks
+static bool patchReceived(vec3i pos, block_t block) {
+  vec3i chunkPos = {toChunkCoord(pos.x), toChunkCoord(pos.y), toChunkCoord(pos.z)};
+
+  for(Terrain::generated_chunk_t& chunk : ChunkStream::received) {
+    if(chunk.pos != chunkPos) {
+      continue;
+    }
+
+    uint8_t x = toLocalCoord(pos.x);
+    uint8_t y = toLocalCoord(pos.y);
+    uint8_t z = toLocalCoord(pos.z);
+
+    chunk.blocks[blockIndex(x, y, z)] = block;
+
+    // a region left marked after its last block is removed only costs a skipped shortcut
+    if(block != AIR) {
+      chunk.occupancy |= 1ull << regionBit(x, y, z);
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+static void lostConnection() {
+  fprintf(stderr, "lost connection to the world server\n");
+  ChunkStream::disconnect();
+}
+
+bool ChunkStream::connect(const char* address) {
+  int handle = Net::connect(address);
+
+  if(handle == -1) {
+    return false;
+  }
+
+  connection = new Net::Connection(handle);
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  Net::message_t message;
+
+  while(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < HELLO_TIMEOUT) {
+    if(!connection->receive()) {
+      break;
+    }
+
+    if(!connection->next(&message)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      continue;
+    }
+
+    if(message.type != Net::HELLO || message.size != 8 || Net::getU32(message.data) != Net::PROTOCOL_VERSION) {
+      fprintf(stderr, "%s: %s is not a version %u world server\n", __func__, address, Net::PROTOCOL_VERSION);
+      break;
+    }
+
+    seed = Net::getU32(message.data + 4);
+    printf("streaming chunks from %s (seed %u)\n", address, seed);
+
+    return true;
+  }
+
+  fprintf(stderr, "%s: no answer from %s\n", __func__, address);
+  disconnect();
+
+  return false;
+}
+
+void ChunkStream::disconnect() {
+  delete connection;
+  connection = nullptr;
+
+  // received chunks were never handed to the chunk manager
+  for(const Terrain::generated_chunk_t& chunk : received) {
+    pool->release(chunk.blocks);
+  }
+
+  received.clear();
+  deltas.clear();
+}
+
+bool ChunkStream::isConnected() {
+  return connection != nullptr;
+}
+
+uint ChunkStream::getSeed() {
+  return seed;
+}
+
+void ChunkStream::request(vec3i pos) {
+  if(connection == nullptr) {
+    return;
+  }
+
+  uint8_t data[12];
+  writePos(data, pos);
+  connection->send(Net::REQUEST, data, sizeof(data));
+}
+
+void ChunkStream::prune(vec3i center, int distance) {
+  if(connection == nullptr) {
+    return;
+  }
+
+  uint8_t data[16];
+  writePos(data, center);
+  Net::putU32(data + 12, (uint)distance);
+  connection->send(Net::PRUNE, data, sizeof(data));
+}
+
+void ChunkStream::sendEdit(int x, int y, int z, block_t block) {
+  if(connection == nullptr) {
+    return;
+  }
+
+  uint8_t data[16];
+  writePos(data, {x, y, z});
+  Net::putU32(data + 12, block);
+  connection->send(Net::EDIT, data, sizeof(data));
+}
+
+uint ChunkStream::collect(std::vector<Terrain::generated_chunk_t>& out, uint max, SlabPool* blockPool) {
+  if(connection == nullptr) {
+    return 0;
+  }
+
+  pool = blockPool;
+
+  if(!connection->flush() || !connection->receive()) {
+    lostConnection();
+    return 0;
+  }
+
+  Net::message_t message;
+
+  while(connection->next(&message)) {
+    if(message.type == Net::DELTA && message.size == 16) {
+      vec3i pos = readPos(message.data);
+      uint id = Net::getU32(message.data + 12);
+
+      if(!isValidBlock(id)) {
+        fprintf(stderr, "%s: invalid block %u at %d %d %d from the server\n", __func__, id, pos.x, pos.y, pos.z);
+        continue;
+      }
+
+      block_t block = (block_t)id;
+
+      if(!patchReceived(pos, block)) {
+        deltas.push_back({pos.x, pos.y, pos.z, block});
+      }
+    } else if(message.type == Net::CHUNK && message.size >= 12) {
+      Terrain::generated_chunk_t chunk;
+      chunk.pos = readPos(message.data);
+      chunk.blocks = (block_t*)pool->allocate();
+
+      if(!WorldStorage::decodeChunk(message.data + 12, message.size - 12, chunk.blocks)) {
+        fprintf(stderr, "%s: invalid chunk %d %d %d from the server\n", __func__, chunk.pos.x, chunk.pos.y, chunk.pos.z);
+        pool->release(chunk.blocks);
+        continue;
+      }
+
+      chunk.occupancy = computeOccupancy(chunk.blocks);
+      received.push_back(chunk);
+    }
+  }
+
+  uint count = 0;
+
+  while(!received.empty() && count < max) {
+    out.push_back(received.front());
+    received.pop_front();
+    count++;
+  }
+
+  return count;
+}
+
+void ChunkStream::collectDeltas(std::vector<World::block_edit_t>& out) {
+  out.insert(out.end(), deltas.begin(), deltas.end());
+  deltas.clear();
+}
@@ -1,13 +1,100 @@
 #include "common.h"
 
-std::string stackTraceName;
-std::string stackTraceFile;
-uint stackTraceLine;
-std::string stackTraceFunc;
-
-void stackTracePush(const char* name, const char* file, uint line, const char* func) {
-  stackTraceName = name;
-  stackTraceFile = file;
-  stackTraceLine = line;
-  stackTraceFunc = func;
+#include <atomic>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// config, main overrides these from config.conf. the defaults are the same
+int viewDistance = 8;
+int maxChunksGeneratedPerFrame = 2;
+int maxChunksDeletedPerFrame = 4;
+bool hugePages = false;
+
+/*
+  rings live in static storage and are never released, so a signal handler
+  can walk every slot that has been handed out without taking locks
+*/
+static breadcrumb_ring_t breadcrumbRings[BREADCRUMB_MAX_THREADS];
+static std::atomic<uint> breadcrumbThreads(0);
+
+thread_local breadcrumb_ring_t* threadBreadcrumbs = nullptr;
+
+breadcrumb_ring_t* registerBreadcrumbThread() {
+  uint index = breadcrumbThreads.fetch_add(1);
+
+  // out of slots, this thread leaves no breadcrumbs
+  if(index >= BREADCRUMB_MAX_THREADS) {
+    return nullptr;
+  }
+
+  threadBreadcrumbs = &breadcrumbRings[index];
+  return threadBreadcrumbs;
+}
+
+void writeSignalSafe(int fd, const char* str) {
+  if(str == nullptr) {
+    str = "?";
+  }
+
+  size_t length = 0;
+
+  while(str[length] != '\0') {
+    length++;
+  }
+
+  if(write(fd, str, length) < 0) {
+    return;
+  }
+}
+
+void writeSignalSafe(int fd, long value) {
+  char buffer[24];
+  char* ptr = buffer + sizeof(buffer);
+  *--ptr = '\0';
+
+  bool negative = value < 0;
+  unsigned long magnitude = negative ? 0ul - (unsigned long)value : (unsigned long)value;
+
+  do {
+    *--ptr = (char)('0' + magnitude % 10);
+    magnitude /= 10;
+  } while(magnitude > 0);
+
+  if(negative) {
+    *--ptr = '-';
+  }
+
+  writeSignalSafe(fd, ptr);
+}
+
+void dumpBreadcrumbs(int fd) {
+  uint threads = MIN(breadcrumbThreads.load(), BREADCRUMB_MAX_THREADS);
+
+  for(uint i = 0; i < threads; i++) {
+    const breadcrumb_ring_t& ring = breadcrumbRings[i];
+    uint head = ring.head;
+    uint count = MIN(head, BREADCRUMB_COUNT);
+
+    writeSignalSafe(fd, "thread ");
+    writeSignalSafe(fd, (long)i);
+    writeSignalSafe(fd, " (oldest first):\n");
+
+    for(uint j = head - count; j != head; j++) {
+      const breadcrumb_t& crumb = ring.crumbs[j & (BREADCRUMB_COUNT - 1)];
+
+      writeSignalSafe(fd, "  ");
+      writeSignalSafe(fd, crumb.file);
+      writeSignalSafe(fd, ":");
+      writeSignalSafe(fd, (long)crumb.line);
+      writeSignalSafe(fd, " (");
+      writeSignalSafe(fd, crumb.func);
+      writeSignalSafe(fd, "): ");
+      writeSignalSafe(fd, crumb.name);
+      writeSignalSafe(fd, "\n");
+    }
+  }
 }
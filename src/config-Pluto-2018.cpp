@@ -3,37 +3,146 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <chrono>
+
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <limits.h>
+#include <sys/inotify.h>
+#endif
+
+// without inotify the modification time is checked this often
+const static double POLL_INTERVAL = 1.0; // seconds
+
+static long getModifiedTime(const char* path) {
+  struct stat info;
+
+  if(stat(path, &info) != 0) {
+    return 0;
+  }
+
+  return (long)info.st_mtime;
+}
+
+static double getSeconds() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
 Config::Config(const char* configPath) {
   path = configPath;
+  watchFd = -1;
+  lastModified = getModifiedTime(path);
+  lastCheck = getSeconds();
+
+#ifdef __linux__
+  // editors often replace the file instead of writing it, so watch its directory
+  const char* slash = strrchr(path, '/');
+  std::string directory = slash != NULL ? std::string(path, slash - path) : std::string(".");
+
+  watchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+  if(watchFd >= 0 && inotify_add_watch(watchFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+    fprintf(stderr, "%s: unable to watch %s\n", __func__, directory.c_str());
+    close(watchFd);
+    watchFd = -1;
+  }
+
+#endif
+
+  reload();
+}
+
+Config::~Config() {
+#ifdef __linux__
+
+  if(watchFd >= 0) {
+    close(watchFd);
+  }
+
+#endif
 }
 
-char* Config::getString(const char* varName) {
+bool Config::reload() {
   FILE* file = fopen(path, "r");
 
   if(file == NULL) {
     fprintf(stderr, "%s: %s not found\n", __func__, path);
-    return NULL;
+    return false;
   }
 
   char name[128];
   char val[128];
-  char* ret = NULL;
+
+  values.clear();
 
   while(fscanf(file, "%127[^=]=%127[^\n]%*c", name, val) == 2) {
-    if(!strcmp(name, varName)) {
-      ret = strdup(val);
-      break;
-    }
+    values[name] = val;
   }
 
   fclose(file);
 
-  return ret;
+  return true;
+}
+
+bool Config::poll() {
+  bool changed = false;
+
+#ifdef __linux__
+
+  if(watchFd >= 0) {
+    alignas(struct inotify_event) char buffer[4096];
+    const char* slash = strrchr(path, '/');
+    const char* fileName = slash != NULL ? slash + 1 : path;
+    ssize_t length;
+
+    while((length = read(watchFd, buffer, sizeof(buffer))) > 0) {
+      for(char* event = buffer; event < buffer + length;) {
+        struct inotify_event* info = (struct inotify_event*)event;
+
+        if(info->len > 0 && strcmp(info->name, fileName) == 0) {
+          changed = true;
+        }
+
+        event += sizeof(struct inotify_event) + info->len;
+      }
+    }
+
+    return changed && reload();
+  }
+
+#endif
+
+  double now = getSeconds();
+
+  if(now - lastCheck < POLL_INTERVAL) {
+    return false;
+  }
+
+  lastCheck = now;
+  long modified = getModifiedTime(path);
+
+  if(modified != lastModified) {
+    lastModified = modified;
+    changed = reload();
+  }
+
+  return changed;
+}
+
+const char* Config::getString(const char* varName) {
+  std::map<std::string, std::string>::iterator it = values.find(varName);
+
+  if(it == values.end()) {
+    return NULL;
+  }
+
+  return it->second.c_str();
 }
 
 int Config::getInt(const char* varName, int defaultValue) {
-  char* temp = getString(varName);
+  const char* temp = getString(varName);
 
   int ret = defaultValue;
 
@@ -44,8 +153,6 @@ int Config::getInt(const char* varName, int defaultValue) {
     if(stop == temp) {
       ret = defaultValue;
     }
-
-    free(temp);
   }
 
   if(ret < 1) {
@@ -58,13 +165,12 @@ int Config::getInt(const char* varName, int defaultValue) {
 }
 
 bool Config::getBool(const char* varName, bool defaultValue) {
-  char* temp = getString(varName);
+  const char* temp = getString(varName);
 
-  bool ret = defaultValue;;
+  bool ret = defaultValue;
 
   if(temp != NULL) {
     ret = strcmp(temp, "true") == 0;
-    free(temp);
   }
 
   printf("%s: %s\n", varName, ret ? "yes" : "no");
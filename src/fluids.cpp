@@ -0,0 +1,165 @@
+#include "fluids.h"
+
+#include <map>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+#include "chunk_manager.h"
+#include "world.h"
+#include "profiler.h"
+
+// simulation ticks per water step, water spreads a block per step
+const uint TICKS_PER_STEP = 6;
+
+// cells looked at per step, the rest carry over so a flood can't stall a tick
+const uint MAX_CELLS_PER_STEP = 8192;
+
+namespace Fluids {
+// block indices to look at next step, per chunk
+std::map<vec3i, std::vector<ushort>> active;
+std::map<vec3i, std::vector<ushort>> processing;
+// new blocks of the step, all computed before any is written so the step doesn't depend on chunk order
+std::vector<World::block_edit_t> pending;
+uint tickCount = 0;
+}
+
+// local coordinates may be one block outside the chunk, unloaded chunks read as solid so water stops at them
+static block_t getBlock(Chunk* chunk, int x, int y, int z) {
+  if(x >= 0 && y >= 0 && z >= 0 && x < CHUNK_SIZE && y < CHUNK_SIZE && z < CHUNK_SIZE) {
+    return chunk->get((uint8_t)x, (uint8_t)y, (uint8_t)z);
+  }
+
+  std::shared_ptr<Chunk> neighbor = ChunkManager::get({chunk->x + toChunkCoord(x), chunk->y + toChunkCoord(y), chunk->z + toChunkCoord(z)});
+
+  if(neighbor == nullptr) {
+    return BEDROCK;
+  }
+
+  return neighbor->get(toLocalCoord(x), toLocalCoord(y), toLocalCoord(z));
+}
+
+// water rests on anything but air and water that is still flowing
+inline bool isSupport(block_t block) {
+  return block != AIR && (!isWater(block) || block == WATER);
+}
+
+/*
+  the block the cell should hold next step. water falling in from above is
+  level 1, otherwise a cell is one level past its lowest resting neighbor.
+  flowing water without a feeding neighbor drains away a level per step
+*/
+static block_t flow(Chunk* chunk, int x, int y, int z) {
+  const int sides[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
+  block_t block = chunk->get((uint8_t)x, (uint8_t)y, (uint8_t)z);
+
+  // sources and solid blocks never change on their own
+  if(block != AIR && (!isWater(block) || block == WATER)) {
+    return block;
+  }
+
+  if(isWater(getBlock(chunk, x, y + 1, z))) {
+    return getWaterBlock(1);
+  }
+
+  uint8_t level = MAX_WATER_LEVEL + 1;
+
+  for(uint i = 0; i < 4; i++) {
+    int nx = x + sides[i][0];
+    int nz = z + sides[i][1];
+    block_t neighbor = getBlock(chunk, nx, y, nz);
+
+    if(isWater(neighbor) && isSupport(getBlock(chunk, nx, y - 1, nz))) {
+      level = MIN(level, (uint8_t)(getWaterLevel(neighbor) + 1));
+    }
+  }
+
+  return level <= MAX_WATER_LEVEL ? getWaterBlock(level) : AIR;
+}
+
+void Fluids::free() {
+  active.clear();
+  processing.clear();
+  pending.clear();
+  tickCount = 0;
+}
+
+void Fluids::activate(int x, int y, int z) {
+  const int offsets[7][3] = {{0, 0, 0}, {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+
+  for(uint i = 0; i < 7; i++) {
+    int bx = x + offsets[i][0];
+    int by = y + offsets[i][1];
+    int bz = z + offsets[i][2];
+
+    vec3i chunkPos = {toChunkCoord(bx), toChunkCoord(by), toChunkCoord(bz)};
+    active[chunkPos].push_back(blockIndex(toLocalCoord(bx), toLocalCoord(by), toLocalCoord(bz)));
+  }
+}
+
+void Fluids::tick() {
+  if(++tickCount % TICKS_PER_STEP != 0 || active.empty()) {
+    return;
+  }
+
+  PROFILE_SCOPE("fluids")
+
+  processing.swap(active);
+
+  uint budget = MAX_CELLS_PER_STEP;
+
+  for(std::pair<const vec3i, std::vector<ushort>>& entry : processing) {
+    std::vector<ushort>& cells = entry.second;
+
+    // queues of unloaded chunks are dropped, their water stays as it was saved
+    std::shared_ptr<Chunk> chunk = ChunkManager::get(entry.first);
+
+    if(chunk == nullptr) {
+      continue;
+    }
+
+    std::sort(cells.begin(), cells.end());
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+
+    const vec3i& pos = entry.first;
+
+    for(size_t i = 0; i < cells.size(); i++) {
+      if(budget == 0) {
+        std::vector<ushort>& carried = active[pos];
+        carried.insert(carried.end(), cells.begin() + i, cells.end());
+        break;
+      }
+
+      budget--;
+
+      ushort index = cells[i];
+      int x = index & (CHUNK_SIZE - 1);
+      int y = (index >> 5) & (CHUNK_SIZE - 1);
+      int z = index >> 10;
+      block_t block = flow(chunk.get(), x, y, z);
+
+      if(block != chunk->get((uint8_t)x, (uint8_t)y, (uint8_t)z)) {
+        pending.push_back({pos.x * CHUNK_SIZE + x, pos.y * CHUNK_SIZE + y, pos.z * CHUNK_SIZE + z, block});
+      }
+    }
+  }
+
+  processing.clear();
+
+  // every changed cell is activated again through the batch
+  if(!pending.empty()) {
+    World::setBlocks(pending);
+    pending.clear();
+  }
+}
+
+uint Fluids::getActiveCount() {
+  uint count = 0;
+
+  for(const std::pair<const vec3i, std::vector<ushort>>& entry : active) {
+    count += (uint)entry.second.size();
+  }
+
+  return count;
+}
@@ -20,8 +20,19 @@ void GL::Buffer<T>::unbind() {
 
 template <GL::BufferType T>
 void GL::Buffer<T>::data(size_t size, const void* data) {
+  this->data(size, data, STATIC_DRAW);
+}
+
+template <GL::BufferType T>
+void GL::Buffer<T>::data(size_t size, const void* data, BufferUsage usage) {
+  bind();
+  glBufferData(T, size, data, usage);
+}
+
+template <GL::BufferType T>
+void GL::Buffer<T>::subData(size_t offset, size_t size, const void* data) {
   bind();
-  glBufferData(T, size, data, GL_STATIC_DRAW);
+  glBufferSubData(T, offset, size, data);
 }
 
 template class GL::Buffer<GL::ARRAY>;
@@ -1,11 +1,8 @@
 #include "gl/instance_buffer.h"
 
-#include <stdio.h>
-#include <math.h>
-#include <typeinfo>
-
 #include <GL/glew.h>
-#include <glm/gtc/matrix_transform.hpp>
+
+#include "gl/utils.h"
 
 #include "common.h"
 
@@ -13,50 +10,26 @@
 
 namespace GL {
 
-template <typename T> InstanceBuffer<T>::InstanceBuffer(VAO* vao, int initialSize, uint attrib) {
+InstanceBuffer::InstanceBuffer(VAO* _vao, int initialSize, uint _stride, std::initializer_list<InstanceAttrib> _layout) : vao(_vao), stride(_stride), layout(_layout), currentLength(0) {
   glGenBuffers(1, &vbo);
-  vao->bind();
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
-
-  if(typeid(T) == typeid(uint)) {
-    vertexSize = sizeof(uint);
-    glEnableVertexAttribArray(attrib);
-    // uint is treated as 4 bytes so it can be used as a color in the shader
-    glVertexAttribPointer(attrib, 4, GL_UNSIGNED_BYTE, GL_TRUE, vertexSize, (void*)0);
-    // must set attribute divisor
-    glVertexAttribDivisor(attrib, 1);
-  } else if(typeid(T) == typeid(glm::mat4)) {
-    vertexSize = sizeof(glm::mat4);
-
-    for(uint i = 0; i < 4; i++) {
-      glEnableVertexAttribArray(attrib + i);
-      // mat4 is treated as 4 sets of 4 floats in the shader
-      glVertexAttribPointer(attrib + i, 4, GL_FLOAT, GL_FALSE, vertexSize, (void*)(sizeof(float) * 4 * i));
-      // must set attrivute divisor
-      glVertexAttribDivisor(attrib + i, 1);
-    }
-  } else {
-    fprintf(stderr, "unknown InstanceBuffer data type\n");
-    exit(-1);
-  }
-
   bufferData(initialSize);
+
+  vao->bind();
+  setBaseInstance(0);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindVertexArray(0);
 }
 
-template <typename T> InstanceBuffer<T>::~InstanceBuffer() {
+InstanceBuffer::~InstanceBuffer() {
   glDeleteBuffers(1, &vbo);
 }
 
-template <typename T>
-inline void InstanceBuffer<T>::bind() {
+void InstanceBuffer::bind() {
   glBindBuffer(GL_ARRAY_BUFFER, vbo);
 }
 
-template <typename T>
-inline void InstanceBuffer<T>::expand(int newLength) {
-  if(newLength < currentLength) {
+void InstanceBuffer::expand(int newLength) {
+  if(newLength <= currentLength) {
     return;
   }
 
@@ -64,17 +37,33 @@ inline void InstanceBuffer<T>::expand(int newLength) {
   bufferData(newLength);
 }
 
-template <typename T>
-inline void InstanceBuffer<T>::bufferData(int newLength) {
+void InstanceBuffer::bufferData(int newLength) {
   currentLength = newLength;
 
   bind();
-  glBufferData(GL_ARRAY_BUFFER, (uint)(currentLength * vertexSize), (void*)0, GL_DYNAMIC_DRAW);
+  glBufferData(GL_ARRAY_BUFFER, (size_t)currentLength * stride, (void*)0, GL_DYNAMIC_DRAW);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-// tell the compiler we will be using these data types
-template class InstanceBuffer<uint>;
-template class InstanceBuffer<glm::mat4>;
+void InstanceBuffer::subData(int first, int count, const void* data) {
+  bind();
+  glBufferSubData(GL_ARRAY_BUFFER, (size_t)first * stride, (size_t)count * stride, data);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::copy(uint source, size_t sourceOffset, int first, int count) {
+  copyBuffer(source, sourceOffset, vbo, (size_t)first * stride, (size_t)count * stride);
+}
+
+// expects the owning vao to be bound
+void InstanceBuffer::setBaseInstance(int first) {
+  size_t base = (size_t)first * stride;
+
+  bind();
 
-}
\ No newline at end of file
+  for(const InstanceAttrib& attrib : layout) {
+    vao->attribPointer(attrib.index, attrib.size, attrib.type, attrib.normalized, stride, base + attrib.offset, 1);
+  }
+}
+
+}
@@ -1,15 +1,171 @@
 #include "gl/shader.h"
 
 #include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#include "asset_pack.h"
+
+// linked programs are saved here per source and driver, so warm starts skip the glsl compiler
+const static char* SHADER_CACHE_DIRECTORY = "shader_cache";
 
 namespace GL {
 
+// fnv-1a, chained so the key covers several strings
+static uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull) {
+  for(size_t i = 0; i < size; i++) {
+    hash ^= ((const uint8_t*)data)[i];
+    hash *= 0x100000001b3ull;
+  }
+
+  return hash;
+}
+
+// a driver update or another gpu changes the key, its binaries would be rejected anyway
+static std::string getCachePath(const ShaderSource& source) {
+  const char* renderer = (const char*)glGetString(GL_RENDERER);
+  const char* version = (const char*)glGetString(GL_VERSION);
+
+  uint64_t hash = hashBytes(source.vertex, source.vertexLength);
+  hash = hashBytes(source.fragment, source.fragmentLength, hash);
+  hash = hashBytes(renderer, renderer ? strlen(renderer) : 0, hash);
+  hash = hashBytes(version, version ? strlen(version) : 0, hash);
+
+  char name[32];
+  snprintf(name, sizeof(name), "/%016llx.bin", (unsigned long long)hash);
+
+  return SHADER_CACHE_DIRECTORY + std::string(name);
+}
+
+static bool isCacheSupported() {
+  if(!GLEW_ARB_get_program_binary && !GLEW_VERSION_4_1) {
+    return false;
+  }
+
+  int formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+  return formats > 0;
+}
+
+// the file is {uint32 format, binary}, 0 if there is none or the driver rejects it
+static uint loadCachedProgram(const std::string& path) {
+  FILE* file = fopen(path.c_str(), "rb");
+
+  if(file == NULL) {
+    return 0;
+  }
+
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  std::vector<uint8_t> data(size > 0 ? size : 0);
+  bool ok = size > (long)sizeof(uint32_t) && fread(data.data(), 1, data.size(), file) == data.size();
+  fclose(file);
+
+  if(!ok) {
+    return 0;
+  }
+
+  uint32_t format;
+  memcpy(&format, data.data(), sizeof(format));
+
+  uint program = glCreateProgram();
+  glProgramBinary(program, format, data.data() + sizeof(format), (int)(data.size() - sizeof(format)));
+
+  int success;
+  glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+  if(!success) {
+    glDeleteProgram(program);
+    return 0;
+  }
+
+  return program;
+}
+
+static void saveCachedProgram(const std::string& path, uint program) {
+  int length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+  if(length <= 0) {
+    return;
+  }
+
+  std::vector<uint8_t> data(sizeof(uint32_t) + length);
+  uint format;
+  glGetProgramBinary(program, length, NULL, &format, data.data() + sizeof(uint32_t));
+  memcpy(data.data(), &format, sizeof(uint32_t));
+
+#ifdef _WIN32
+  _mkdir(SHADER_CACHE_DIRECTORY);
+#else
+  mkdir(SHADER_CACHE_DIRECTORY, 0755);
+#endif
+
+  FILE* file = fopen(path.c_str(), "wb");
+
+  if(file == NULL) {
+    fprintf(stderr, "%s: unable to write %s\n", __func__, path.c_str());
+    return;
+  }
+
+  fwrite(data.data(), 1, data.size(), file);
+  fclose(file);
+}
+
+static ShaderSource loadSource(const char* name) {
+  ShaderSource source = {nullptr, nullptr, 0, 0};
+  AssetPack::asset_t vertex, fragment;
+
+  if(!AssetPack::get((std::string("shaders/") + name + "/vertex.glsl").c_str(), &vertex) || !AssetPack::get((std::string("shaders/") + name + "/fragment.glsl").c_str(), &fragment)) {
+    fprintf(stderr, "%s: missing shader %s\n", __func__, name);
+    return source;
+  }
+
+  source.vertex = (const char*)vertex.data;
+  source.fragment = (const char*)fragment.data;
+  source.vertexLength = (int)vertex.size;
+  source.fragmentLength = (int)fragment.size;
+
+  return source;
+}
+
+Shader::Shader(const char* name) : Shader(loadSource(name)) {
+}
+
 Shader::Shader(ShaderSource source) {
   int success;
 
+  // use() reports the missing program
+  if(source.vertex == nullptr || source.fragment == nullptr) {
+    return;
+  }
+
+  bool cache = isCacheSupported();
+  std::string cachePath;
+
+  if(cache) {
+    cachePath = getCachePath(source);
+    id = loadCachedProgram(cachePath);
+
+    // otherwise missing, or rejected after a driver change, so it is rebuilt from source
+    if(id != 0) {
+      return;
+    }
+  }
+
   uint vertexShader;
   vertexShader = glCreateShader(GL_VERTEX_SHADER);
-  glShaderSource(vertexShader, 1, &source.vertex, NULL);
+  glShaderSource(vertexShader, 1, &source.vertex, &source.vertexLength);
   glCompileShader(vertexShader);
 
   // check compile errors
@@ -28,7 +184,7 @@ Shader::Shader(ShaderSource source) {
 
   uint fragmentShader;
   fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-  glShaderSource(fragmentShader, 1, &source.fragment, NULL);
+  glShaderSource(fragmentShader, 1, &source.fragment, &source.fragmentLength);
   glCompileShader(fragmentShader);
 
   // check compile errors
@@ -48,6 +204,10 @@ Shader::Shader(ShaderSource source) {
   uint shaderProgram;
   shaderProgram = glCreateProgram();
 
+  if(cache) {
+    glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
+
   glAttachShader(shaderProgram, vertexShader);
   glAttachShader(shaderProgram, fragmentShader);
   glLinkProgram(shaderProgram);
@@ -64,11 +224,15 @@ Shader::Shader(ShaderSource source) {
     printf(infoLog);
     printf("\n");
 
-    glDeleteShader(shaderProgram);
+    glDeleteProgram(shaderProgram);
     return;
   }
 
   id = shaderProgram;
+
+  if(cache) {
+    saveCachedProgram(cachePath, id);
+  }
 }
 
 Shader::~Shader() {
@@ -0,0 +1,121 @@
+#include "gl/stream_buffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "memory_tracker.h"
+
+namespace GL {
+
+StreamBuffer::StreamBuffer(size_t _regionSize, uint _regionCount) {
+  // keep every region aligned so any element type can be written at its start
+  regionSize = (_regionSize + 255) & ~(size_t)255;
+  regionCount = _regionCount;
+  region = 0;
+  used = 0;
+  mappedOffset = 0;
+  mappedSize = 0;
+
+  fences = new GLsync[regionCount];
+
+  for(uint i = 0; i < regionCount; i++) {
+    fences[i] = 0;
+  }
+
+  size_t size = regionSize * regionCount;
+  persistent = GLEW_ARB_buffer_storage || GLEW_VERSION_4_4;
+
+  glGenBuffers(1, &handle);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, handle);
+
+  if(persistent) {
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_COPY_WRITE_BUFFER, size, NULL, flags);
+    memory = (uint8_t*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags);
+
+    if(memory == NULL) {
+      fprintf(stderr, "%s: persistent mapping failed\n", __func__);
+      exit(-1);
+    }
+  } else {
+    glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_STREAM_DRAW);
+    memory = (uint8_t*)MemoryTracker::allocate(size, MemoryTracker::GL_WRAPPERS);
+  }
+
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+StreamBuffer::~StreamBuffer() {
+  for(uint i = 0; i < regionCount; i++) {
+    if(fences[i] != 0) {
+      glDeleteSync(fences[i]);
+    }
+  }
+
+  if(persistent) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, handle);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  } else {
+    MemoryTracker::release(memory);
+  }
+
+  glDeleteBuffers(1, &handle);
+  delete[] fences;
+}
+
+void* StreamBuffer::map(size_t size) {
+  size_t offset = (used + 15) & ~(size_t)15;
+
+  if(offset + size > regionSize) {
+    return nullptr;
+  }
+
+  used = offset + size;
+  mappedOffset = region * regionSize + offset;
+  mappedSize = size;
+
+  return memory + mappedOffset;
+}
+
+size_t StreamBuffer::commit() {
+  if(!persistent && mappedSize > 0) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, handle);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, mappedOffset, mappedSize, memory + mappedOffset);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  }
+
+  mappedSize = 0;
+
+  return mappedOffset;
+}
+
+void StreamBuffer::endFrame() {
+  // nothing was written, the region can be reused as is
+  if(used == 0) {
+    return;
+  }
+
+  if(fences[region] != 0) {
+    glDeleteSync(fences[region]);
+  }
+
+  fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  region = (region + 1) % regionCount;
+  used = 0;
+
+  // only waits if the gpu is more than regionCount - 1 frames behind
+  if(fences[region] != 0) {
+    GLenum result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+    while(result == GL_TIMEOUT_EXPIRED) {
+      result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    }
+
+    glDeleteSync(fences[region]);
+    fences[region] = 0;
+  }
+}
+
+}
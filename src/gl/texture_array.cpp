@@ -1,35 +1,48 @@
 #include "gl/texture_array.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+GL::TextureArray::TextureArray(uint index, const uint8_t* blob, size_t size) {
+  uint32_t header[4];
+  size_t expected = sizeof(header);
 
-GL::TextureArray::TextureArray(uint index, uint textureCount, uint textureRes, uint8_t* loadTexture(int)) {
-  glActiveTexture(GL_TEXTURE0 + index);
+  if(size >= sizeof(header)) {
+    for(uint i = 0; i < 4; i++) {
+      header[i] = blob[i * 4] | (blob[i * 4 + 1] << 8) | (blob[i * 4 + 2] << 16) | ((uint32_t)blob[i * 4 + 3] << 24);
+    }
 
-  glGenTextures(1, &handle);
-  glBindTexture(GL_TEXTURE_2D_ARRAY, handle);
-  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_SRGB_ALPHA, textureRes, textureRes, textureCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    for(uint level = 0; level < header[2]; level++) {
+      size_t res = MAX(header[1] >> level, 1u);
+      expected += res * res * header[0] * 4;
+    }
+  }
 
-  stbi_set_flip_vertically_on_load(true);
+  if(size < sizeof(header) || header[2] == 0 || size != expected) {
+    fprintf(stderr, "%s: texture blob doesn't match its header\n", __func__);
+    exit(-1);
+  }
 
-  uint8_t* imageData;
+  uint textureCount = header[0];
+  uint textureRes = header[1];
+  uint levels = header[2];
+  const uint8_t* data = blob + sizeof(header);
 
-  for(int i = 0; i < (int)textureCount; i++) {
-    imageData = loadTexture(i);
+  glActiveTexture(GL_TEXTURE0 + index);
 
-    if(imageData) {
-      glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, textureRes, textureRes, 1, GL_RGBA, GL_UNSIGNED_BYTE, imageData);
-    } else {
-      fprintf(stderr, "error loading texture\n");
-      exit(-1);
-    }
+  glGenTextures(1, &handle);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, handle);
+
+  // the chain is built offline, so each level is a single upload straight from the blob
+  for(uint level = 0; level < levels; level++) {
+    uint res = MAX(textureRes >> level, 1u);
 
-    stbi_image_free(imageData);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_SRGB_ALPHA, res, res, textureCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    data += (size_t)res * res * textureCount * 4;
   }
 
-  glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
   glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
   glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
   glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
@@ -4,10 +4,6 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
-template <typename T> T* GL::mapBuffer() {
-  return (T*)glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-}
-
 void GL::init() {
   glewExperimental = true;
 
@@ -17,8 +13,13 @@ void GL::init() {
   }
 }
 
-void GL::unmapBuffer() {
-  glUnmapBuffer(GL_ARRAY_BUFFER);
+// gpu side copy between two buffers, does not wait for either
+void GL::copyBuffer(uint source, size_t sourceOffset, uint destination, size_t destinationOffset, size_t size) {
+  glBindBuffer(GL_COPY_READ_BUFFER, source);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, destination);
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sourceOffset, destinationOffset, size);
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
 }
 
 void GL::drawInstanced(uint verticesCount, uint objectCount) {
@@ -64,7 +65,3 @@ void GL::setClearColor(float red, float green, float blue, float alpha) {
 void GL::clear(uint mask) {
   glClear(mask);
 }
-
-// tell the compiler we will be using these data types
-template uint* GL::mapBuffer<uint>();
-template glm::mat4* GL::mapBuffer<glm::mat4>();
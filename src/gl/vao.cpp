@@ -34,5 +34,11 @@ void GL::VAO::attribI(uint index, uint size, DataType type) {
   glEnableVertexAttribArray(index);
 }
 
+void GL::VAO::attribPointer(uint index, uint size, DataType type, bool normalized, uint stride, size_t offset, uint divisor) {
+  glVertexAttribPointer(index, size, type, normalized ? GL_TRUE : GL_FALSE, stride, (void*)offset);
+  glEnableVertexAttribArray(index);
+  glVertexAttribDivisor(index, divisor);
+}
+
 template void GL::VAO::attrib<int8_t>(uint, uint, DataType);
 template void GL::VAO::attrib<int8_t>(uint, uint, DataType, uint);
@@ -3,28 +3,27 @@
 #include <map>
 
 std::map<Input::Key, Input::KeyEvent> keyMap;
+std::map<Input::MouseButton, Input::KeyEvent> mouseMap;
 GLFWwindow* glfwWindow;
 
-void keyCallback(GLFWwindow* _window, int key, int scancode, int action, int mods) {
-  Input::Key _key = (Input::Key)key;
-
+void applyAction(Input::KeyEvent& event, int action) {
   switch(action) {
     case GLFW_PRESS:
-      keyMap[_key].pressed = true;
-      keyMap[_key].released = false;
-      keyMap[_key].down = true;
+      event.pressed = true;
+      event.released = false;
+      event.down = true;
       break;
 
     case GLFW_REPEAT:
-      keyMap[_key].pressed = false;
-      keyMap[_key].released = false;
-      keyMap[_key].down = true;
+      event.pressed = false;
+      event.released = false;
+      event.down = true;
       break;
 
     case GLFW_RELEASE:
-      keyMap[_key].pressed = false;
-      keyMap[_key].released = true;
-      keyMap[_key].down = false;
+      event.pressed = false;
+      event.released = true;
+      event.down = false;
       break;
 
     default:
@@ -32,10 +31,19 @@ void keyCallback(GLFWwindow* _window, int key, int scancode, int action, int mod
   }
 }
 
+void keyCallback(GLFWwindow* _window, int key, int scancode, int action, int mods) {
+  applyAction(keyMap[(Input::Key)key], action);
+}
+
+void mouseButtonCallback(GLFWwindow* _window, int button, int action, int mods) {
+  applyAction(mouseMap[(Input::MouseButton)button], action);
+}
+
 void Input::init(GLFWwindow* _window) {
   glfwWindow = _window;
 
   glfwSetKeyCallback(glfwWindow, keyCallback);
+  glfwSetMouseButtonCallback(glfwWindow, mouseButtonCallback);
 }
 
 void Input::update() {
@@ -50,6 +58,11 @@ void Input::update() {
 
     keyMap[keyEvent.first] = keyEvent.second;
   }
+
+  for(std::pair<const Input::MouseButton, Input::KeyEvent>& buttonEvent : mouseMap) {
+    buttonEvent.second.pressed = false;
+    buttonEvent.second.released = false;
+  }
 }
 
 Input::KeyEvent Input::getKey(Input::Key keycode) {
@@ -62,6 +75,12 @@ Input::KeyEvent Input::getKey(Input::Key keycode) {
   return {};
 }
 
-bool Input::getMosue(Input::MouseButton button) {
-  return glfwGetMouseButton(glfwWindow, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+Input::KeyEvent Input::getMosue(Input::MouseButton button) {
+  auto it = mouseMap.find(button);
+
+  if(it != mouseMap.end()) {
+    return it->second;
+  }
+
+  return {};
 }
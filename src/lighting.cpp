@@ -0,0 +1,863 @@
+#include "lighting.h"
+
+#include <string.h>
+#include <map>
+#include <deque>
+#include <thread>
+#include <condition_variable>
+
+#include "profiler.h"
+
+// nodes propagated before the worker lets go of the mutex, keeps meshing and edits from waiting long
+const uint NODES_PER_BATCH = 4096;
+
+enum Direction : uint8_t {
+  DIR_PX = 0,
+  DIR_NX,
+  DIR_PY,
+  DIR_NY,
+  DIR_PZ,
+  DIR_NZ,
+  DIRECTION_COUNT
+};
+
+// the lighting worker's view of a loaded chunk
+struct light_chunk_t {
+  // nullptr once removed, the entry stays until no queued node can point at it
+  Chunk* chunk;
+  vec3i pos;
+  light_chunk_t* neighbors[DIRECTION_COUNT];
+  bool dirty;
+};
+
+struct light_node_t {
+  light_chunk_t* lc;
+  ushort index;
+  // the level a removal node had before it was cleared
+  uint8_t level;
+};
+
+enum JobType : uint8_t {
+  ADD_CHUNK,
+  RESEED_CHUNK,
+  BLOCK
+};
+
+struct light_job_t {
+  JobType type;
+  // chunk position, or the world block for BLOCK
+  vec3i pos;
+  Chunk* chunk;
+};
+
+enum SeedStage : uint8_t {
+  SEED_COLUMNS,
+  SEED_SPREAD
+};
+
+// a chunk lit over several batches, each stage waits for the removals in flight
+struct light_seed_t {
+  light_chunk_t* lc;
+  SeedStage stage;
+  uint8_t bottoms[CHUNK_SIZE][CHUNK_SIZE];
+};
+
+typedef std::deque<light_node_t> light_queue;
+
+namespace Lighting {
+std::mutex mutex;
+
+// guards jobs, changed and running, never held while waiting for mutex
+std::mutex queueMutex;
+std::condition_variable queueCondition;
+std::deque<light_job_t> jobs;
+std::vector<vec3i> changed;
+bool running = false;
+std::thread worker;
+
+// worker state, only touched with mutex held
+std::map<vec3i, light_chunk_t> lightChunks;
+light_queue sunAdd, sunRemove, blockAdd, blockRemove;
+std::vector<light_chunk_t*> dirtyChunks;
+light_seed_t seed = {nullptr, SEED_COLUMNS, {}};
+uint removedCount = 0;
+}
+
+inline bool isLive(const light_chunk_t* lc) {
+  return lc != nullptr && lc->chunk != nullptr;
+}
+
+inline uint8_t getX(ushort index) {
+  return index & (CHUNK_SIZE - 1);
+}
+
+inline uint8_t getY(ushort index) {
+  return (index >> 5) & (CHUNK_SIZE - 1);
+}
+
+inline uint8_t getZ(ushort index) {
+  return index >> 10;
+}
+
+template<bool SUN>
+inline uint8_t getLevel(const light_chunk_t* lc, ushort index) {
+  uint8_t value = lc->chunk->getLight()[index];
+  return SUN ? value >> 4 : value & 15;
+}
+
+template<bool SUN>
+inline void setLevel(light_chunk_t* lc, ushort index, uint8_t level) {
+  uint8_t& value = lc->chunk->getLight()[index];
+  value = SUN ? (uint8_t)((value & 15) | (level << 4)) : (uint8_t)((value & 0xf0) | level);
+}
+
+inline block_t getBlock(const light_chunk_t* lc, ushort index) {
+  return lc->chunk->getBlocks()[index];
+}
+
+// moves to the block next to index, false if it lies in a chunk that isn't loaded
+inline bool step(light_chunk_t*& lc, ushort& index, uint8_t direction) {
+  uint8_t x = getX(index);
+  uint8_t y = getY(index);
+  uint8_t z = getZ(index);
+
+  switch(direction) {
+    case DIR_PX:
+      if(x == CHUNK_SIZE - 1) {
+        lc = lc->neighbors[DIR_PX];
+        x = 0;
+      } else {
+        x++;
+      }
+
+      break;
+
+    case DIR_NX:
+      if(x == 0) {
+        lc = lc->neighbors[DIR_NX];
+        x = CHUNK_SIZE - 1;
+      } else {
+        x--;
+      }
+
+      break;
+
+    case DIR_PY:
+      if(y == CHUNK_SIZE - 1) {
+        lc = lc->neighbors[DIR_PY];
+        y = 0;
+      } else {
+        y++;
+      }
+
+      break;
+
+    case DIR_NY:
+      if(y == 0) {
+        lc = lc->neighbors[DIR_NY];
+        y = CHUNK_SIZE - 1;
+      } else {
+        y--;
+      }
+
+      break;
+
+    case DIR_PZ:
+      if(z == CHUNK_SIZE - 1) {
+        lc = lc->neighbors[DIR_PZ];
+        z = 0;
+      } else {
+        z++;
+      }
+
+      break;
+
+    case DIR_NZ:
+      if(z == 0) {
+        lc = lc->neighbors[DIR_NZ];
+        z = CHUNK_SIZE - 1;
+      } else {
+        z--;
+      }
+
+      break;
+  }
+
+  index = blockIndex(x, y, z);
+
+  return isLive(lc);
+}
+
+static void markChunkDirty(light_chunk_t* lc) {
+  if(isLive(lc) && !lc->dirty) {
+    lc->dirty = true;
+    Lighting::dirtyChunks.push_back(lc);
+  }
+}
+
+// the neighbors build their border faces from this block's light too
+static void markDirty(light_chunk_t* lc, ushort index) {
+  markChunkDirty(lc);
+
+  uint8_t x = getX(index);
+  uint8_t y = getY(index);
+  uint8_t z = getZ(index);
+
+  if(x == 0) {
+    markChunkDirty(lc->neighbors[DIR_NX]);
+  } else if(x == CHUNK_SIZE - 1) {
+    markChunkDirty(lc->neighbors[DIR_PX]);
+  }
+
+  if(y == 0) {
+    markChunkDirty(lc->neighbors[DIR_NY]);
+  } else if(y == CHUNK_SIZE - 1) {
+    markChunkDirty(lc->neighbors[DIR_PY]);
+  }
+
+  if(z == 0) {
+    markChunkDirty(lc->neighbors[DIR_NZ]);
+  } else if(z == CHUNK_SIZE - 1) {
+    markChunkDirty(lc->neighbors[DIR_PZ]);
+  }
+}
+
+/*
+  light a block holds on its own: what it emits, or for sunlight the open sky
+  above the top layer of a chunk with nothing loaded above it. the sky guess
+  is corrected once that chunk arrives
+*/
+template<bool SUN>
+inline uint8_t getSourceLevel(const light_chunk_t* lc, ushort index) {
+  block_t block = getBlock(lc, index);
+
+  if(!SUN) {
+    return getBlockEmission(block);
+  }
+
+  if(getY(index) != CHUNK_SIZE - 1 || isLive(lc->neighbors[DIR_PY])) {
+    return 0;
+  }
+
+  return isSunTransparent(block) ? MAX_LIGHT : isLightTransparent(block) ? MAX_LIGHT - 1 : 0;
+}
+
+template<bool SUN>
+static void propagateAdd(light_queue& queue, uint& budget) {
+  while(!queue.empty() && budget > 0) {
+    light_node_t node = queue.front();
+    queue.pop_front();
+    budget--;
+
+    if(!isLive(node.lc)) {
+      continue;
+    }
+
+    uint8_t level = getLevel<SUN>(node.lc, node.index);
+
+    if(level <= 1) {
+      continue;
+    }
+
+    for(uint8_t d = 0; d < DIRECTION_COUNT; d++) {
+      light_chunk_t* lc = node.lc;
+      ushort index = node.index;
+
+      if(!step(lc, index, d)) {
+        continue;
+      }
+
+      block_t block = getBlock(lc, index);
+
+      if(!isLightTransparent(block)) {
+        continue;
+      }
+
+      uint8_t next = SUN && d == DIR_NY && level == MAX_LIGHT && isSunTransparent(block) ? MAX_LIGHT : level - 1;
+
+      if(getLevel<SUN>(lc, index) < next) {
+        setLevel<SUN>(lc, index, next);
+        markDirty(lc, index);
+        queue.push_back({lc, index, 0});
+      }
+    }
+  }
+}
+
+/*
+  clears light that may have come from the removed nodes. anything at least
+  as bright as the node that reached it has another source and is queued to
+  flow back into the cleared volume
+*/
+template<bool SUN>
+static void propagateRemove(light_queue& queue, light_queue& addQueue, uint& budget) {
+  while(!queue.empty() && budget > 0) {
+    light_node_t node = queue.front();
+    queue.pop_front();
+    budget--;
+
+    if(!isLive(node.lc)) {
+      continue;
+    }
+
+    for(uint8_t d = 0; d < DIRECTION_COUNT; d++) {
+      light_chunk_t* lc = node.lc;
+      ushort index = node.index;
+
+      if(!step(lc, index, d)) {
+        continue;
+      }
+
+      uint8_t level = getLevel<SUN>(lc, index);
+
+      if(level == 0) {
+        continue;
+      }
+
+      uint8_t source = getSourceLevel<SUN>(lc, index);
+      bool fromNode = level < node.level || (SUN && d == DIR_NY && node.level == MAX_LIGHT && level == MAX_LIGHT);
+
+      if(fromNode && level > source) {
+        setLevel<SUN>(lc, index, source);
+        markDirty(lc, index);
+        queue.push_back({lc, index, level});
+
+        if(source > 0) {
+          addQueue.push_back({lc, index, 0});
+        }
+      } else {
+        addQueue.push_back({lc, index, 0});
+      }
+    }
+  }
+}
+
+// removals first, so adds never spread light that is about to be cleared
+static void propagate(uint budget) {
+  using namespace Lighting;
+
+  propagateRemove<true>(sunRemove, sunAdd, budget);
+  propagateRemove<false>(blockRemove, blockAdd, budget);
+  propagateAdd<true>(sunAdd, budget);
+  propagateAdd<false>(blockAdd, budget);
+}
+
+inline bool isRemoving() {
+  return !Lighting::sunRemove.empty() || !Lighting::blockRemove.empty();
+}
+
+inline bool isPropagating() {
+  return isRemoving() || !Lighting::sunAdd.empty() || !Lighting::blockAdd.empty();
+}
+
+template<bool SUN>
+static void relightBlock(light_chunk_t* lc, ushort index, light_queue& addQueue, light_queue& removeQueue) {
+  uint8_t old = getLevel<SUN>(lc, index);
+  uint8_t source = getSourceLevel<SUN>(lc, index);
+
+  setLevel<SUN>(lc, index, source);
+  markDirty(lc, index);
+
+  if(old > source) {
+    removeQueue.push_back({lc, index, old});
+  }
+
+  if(source > 0) {
+    addQueue.push_back({lc, index, 0});
+  }
+
+  // a block that lets light through again is refilled from around it
+  for(uint8_t d = 0; d < DIRECTION_COUNT; d++) {
+    light_chunk_t* neighbor = lc;
+    ushort neighborIndex = index;
+
+    if(step(neighbor, neighborIndex, d) && getLevel<SUN>(neighbor, neighborIndex) > 0) {
+      addQueue.push_back({neighbor, neighborIndex, 0});
+    }
+  }
+}
+
+// the chunk below may have guessed open sky where this chunk now casts shade
+static void correctSkyBelow(light_chunk_t* lc) {
+  light_chunk_t* below = lc->neighbors[DIR_NY];
+
+  if(!isLive(below)) {
+    return;
+  }
+
+  for(uint8_t z = 0; z < CHUNK_SIZE; z++) {
+    for(uint8_t x = 0; x < CHUNK_SIZE; x++) {
+      ushort top = blockIndex(x, CHUNK_SIZE - 1, z);
+      ushort bottom = blockIndex(x, 0, z);
+      block_t block = getBlock(below, top);
+
+      uint8_t above = getLevel<true>(lc, bottom);
+      uint8_t expected = above == MAX_LIGHT && isSunTransparent(block) ? MAX_LIGHT : (isLightTransparent(block) && above > 0 ? above - 1 : 0);
+      uint8_t level = getLevel<true>(below, top);
+
+      if(level > expected) {
+        setLevel<true>(below, top, 0);
+        markDirty(below, top);
+        Lighting::sunRemove.push_back({below, top, level});
+      }
+    }
+  }
+}
+
+// first stage of lighting a chunk from scratch, fills each column down from the sky or the full sunlight above it
+static void seedColumns(light_chunk_t* lc, uint8_t bottoms[CHUNK_SIZE][CHUNK_SIZE]) {
+  using namespace Lighting;
+
+  light_chunk_t* above = lc->neighbors[DIR_PY];
+
+  for(uint8_t z = 0; z < CHUNK_SIZE; z++) {
+    for(uint8_t x = 0; x < CHUNK_SIZE; x++) {
+      int y = CHUNK_SIZE;
+
+      if(!isLive(above) || getLevel<true>(above, blockIndex(x, 0, z)) == MAX_LIGHT) {
+        while(y > 0 && isSunTransparent(getBlock(lc, blockIndex(x, y - 1, z)))) {
+          y--;
+          setLevel<true>(lc, blockIndex(x, y, z), MAX_LIGHT);
+        }
+
+        // the sky guess also dims into a partly transparent top block
+        if(!isLive(above) && y == CHUNK_SIZE) {
+          uint8_t source = getSourceLevel<true>(lc, blockIndex(x, CHUNK_SIZE - 1, z));
+
+          if(source > getLevel<true>(lc, blockIndex(x, CHUNK_SIZE - 1, z))) {
+            setLevel<true>(lc, blockIndex(x, CHUNK_SIZE - 1, z), source);
+            sunAdd.push_back({lc, blockIndex(x, CHUNK_SIZE - 1, z), 0});
+          }
+        }
+      }
+
+      bottoms[x][z] = (uint8_t)y;
+    }
+  }
+
+  // with the columns filled the chunk below can be checked against what actually reaches it
+  correctSkyBelow(lc);
+}
+
+// second stage, once the removals are done: spreads the columns, emitting blocks and whatever the loaded neighbors shine in
+static void seedSpread(light_chunk_t* lc, const uint8_t bottoms[CHUNK_SIZE][CHUNK_SIZE]) {
+  using namespace Lighting;
+
+  // only the sunlit blocks beside a darker column spread sideways, and each column's lowest one spreads down
+  for(int z = 0; z < CHUNK_SIZE; z++) {
+    for(int x = 0; x < CHUNK_SIZE; x++) {
+      int bottom = bottoms[x][z];
+      int top = bottom;
+
+      if(x > 0) {
+        top = MAX(top, (int)bottoms[x - 1][z]);
+      }
+
+      if(x < CHUNK_SIZE - 1) {
+        top = MAX(top, (int)bottoms[x + 1][z]);
+      }
+
+      if(z > 0) {
+        top = MAX(top, (int)bottoms[x][z - 1]);
+      }
+
+      if(z < CHUNK_SIZE - 1) {
+        top = MAX(top, (int)bottoms[x][z + 1]);
+      }
+
+      top = MIN(MAX(top, bottom + 1), CHUNK_SIZE);
+
+      for(int y = bottom; y < top; y++) {
+        sunAdd.push_back({lc, blockIndex(x, y, z), 0});
+      }
+    }
+  }
+
+  // emitting blocks, skipping regions that only hold air
+  Chunk* chunk = lc->chunk;
+
+  for(ushort i = 0; i < CHUNK_SIZE_CUBED; i++) {
+    uint8_t emission = getBlockEmission(getBlock(lc, i));
+
+    // light that already spread in since the first stage is kept
+    if(emission > getLevel<false>(lc, i)) {
+      setLevel<false>(lc, i, emission);
+      blockAdd.push_back({lc, i, 0});
+    } else if(chunk->isRegionEmpty(getX(i), getY(i), getZ(i)) && getX(i) % CHUNK_REGION_SIZE == 0) {
+      i += CHUNK_REGION_SIZE - 1;
+    }
+  }
+
+  // light crosses the faces in both directions, the add queues ignore what can't brighten anything
+  for(uint8_t d = 0; d < DIRECTION_COUNT; d++) {
+    light_chunk_t* neighbor = lc->neighbors[d];
+
+    if(!isLive(neighbor)) {
+      continue;
+    }
+
+    for(uint8_t a = 0; a < CHUNK_SIZE; a++) {
+      for(uint8_t b = 0; b < CHUNK_SIZE; b++) {
+        uint8_t inside = d == DIR_PX || d == DIR_PY || d == DIR_PZ ? CHUNK_SIZE - 1 : 0;
+        uint8_t outside = CHUNK_SIZE - 1 - inside;
+        ushort own, other;
+
+        if(d == DIR_PX || d == DIR_NX) {
+          own = blockIndex(inside, a, b);
+          other = blockIndex(outside, a, b);
+        } else if(d == DIR_PY || d == DIR_NY) {
+          own = blockIndex(a, inside, b);
+          other = blockIndex(a, outside, b);
+        } else {
+          own = blockIndex(a, b, inside);
+          other = blockIndex(a, b, outside);
+        }
+
+        if(getLevel<true>(neighbor, other) > 1) {
+          sunAdd.push_back({neighbor, other, 0});
+        }
+
+        if(getLevel<false>(neighbor, other) > 1) {
+          blockAdd.push_back({neighbor, other, 0});
+        }
+
+        if(getLevel<true>(lc, own) > 1) {
+          sunAdd.push_back({lc, own, 0});
+        }
+
+        if(getLevel<false>(lc, own) > 1) {
+          blockAdd.push_back({lc, own, 0});
+        }
+      }
+    }
+  }
+
+  // remeshed even if it stayed dark, that is what lets it be meshed at all. the neighbors' border faces look into it
+  markChunkDirty(lc);
+
+  for(uint8_t d = 0; d < DIRECTION_COUNT; d++) {
+    markChunkDirty(lc->neighbors[d]);
+  }
+}
+
+static light_chunk_t* addLightChunk(Chunk* chunk) {
+  using namespace Lighting;
+
+  vec3i pos = {chunk->x, chunk->y, chunk->z};
+  std::map<vec3i, light_chunk_t>::iterator existing = lightChunks.find(pos);
+
+  // reuses the entry of an unloaded chunk, its neighbors are still linked
+  if(existing != lightChunks.end()) {
+    existing->second.chunk = chunk;
+    removedCount--;
+    return &existing->second;
+  }
+
+  light_chunk_t& lc = lightChunks[pos];
+
+  {
+    const vec3i offsets[DIRECTION_COUNT] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+
+    lc.pos = pos;
+    lc.dirty = false;
+
+    for(uint8_t d = 0; d < DIRECTION_COUNT; d++) {
+      std::map<vec3i, light_chunk_t>::iterator it = lightChunks.find({pos.x + offsets[d].x, pos.y + offsets[d].y, pos.z + offsets[d].z});
+      lc.neighbors[d] = it != lightChunks.end() ? &it->second : nullptr;
+
+      // opposite directions differ in the lowest bit
+      if(lc.neighbors[d] != nullptr) {
+        lc.neighbors[d]->neighbors[d ^ 1] = &lc;
+      }
+    }
+  }
+
+  lc.chunk = chunk;
+
+  return &lc;
+}
+
+// drops the entries of unloaded chunks once no queued node can reach them
+static void dropRemovedChunks() {
+  using namespace Lighting;
+
+  for(std::map<vec3i, light_chunk_t>::iterator it = lightChunks.begin(); it != lightChunks.end();) {
+    light_chunk_t& lc = it->second;
+
+    if(lc.chunk != nullptr) {
+      it++;
+      continue;
+    }
+
+    for(uint8_t d = 0; d < DIRECTION_COUNT; d++) {
+      if(lc.neighbors[d] != nullptr) {
+        lc.neighbors[d]->neighbors[d ^ 1] = nullptr;
+      }
+    }
+
+    it = lightChunks.erase(it);
+  }
+
+  removedCount = 0;
+}
+
+static light_chunk_t* findLightChunk(vec3i pos) {
+  std::map<vec3i, light_chunk_t>::iterator it = Lighting::lightChunks.find(pos);
+
+  if(it == Lighting::lightChunks.end() || it->second.chunk == nullptr) {
+    return nullptr;
+  }
+
+  return &it->second;
+}
+
+static void runJob(const light_job_t& job) {
+  using namespace Lighting;
+
+  switch(job.type) {
+    case ADD_CHUNK: {
+      light_chunk_t* lc = addLightChunk(job.chunk);
+      memset(lc->chunk->getLight(), 0, CHUNK_SIZE_CUBED);
+      lc->chunk->seeding = true;
+      seed.lc = lc;
+      seedColumns(lc, seed.bottoms);
+      seed.stage = SEED_SPREAD;
+      break;
+    }
+
+    case RESEED_CHUNK: {
+      light_chunk_t* lc = findLightChunk(job.pos);
+
+      if(lc == nullptr) {
+        break;
+      }
+
+      // whatever this chunk lit in its neighbors goes with it, then it is lit again from scratch
+      uint8_t* light = lc->chunk->getLight();
+
+      for(ushort i = 0; i < CHUNK_SIZE_CUBED; i++) {
+        uint8_t x = getX(i), y = getY(i), z = getZ(i);
+        bool border = x == 0 || y == 0 || z == 0 || x == CHUNK_SIZE - 1 || y == CHUNK_SIZE - 1 || z == CHUNK_SIZE - 1;
+
+        if(border && (light[i] >> 4) > 0) {
+          sunRemove.push_back({lc, i, (uint8_t)(light[i] >> 4)});
+        }
+
+        if(border && (light[i] & 15) > 0) {
+          blockRemove.push_back({lc, i, (uint8_t)(light[i] & 15)});
+        }
+      }
+
+      memset(light, 0, CHUNK_SIZE_CUBED);
+      lc->chunk->seeding = true;
+      seed.lc = lc;
+      seed.stage = SEED_COLUMNS;
+      break;
+    }
+
+    case BLOCK: {
+      light_chunk_t* lc = findLightChunk({toChunkCoord(job.pos.x), toChunkCoord(job.pos.y), toChunkCoord(job.pos.z)});
+
+      if(lc == nullptr) {
+        break;
+      }
+
+      ushort index = blockIndex(toLocalCoord(job.pos.x), toLocalCoord(job.pos.y), toLocalCoord(job.pos.z));
+      relightBlock<true>(lc, index, sunAdd, sunRemove);
+      relightBlock<false>(lc, index, blockAdd, blockRemove);
+      break;
+    }
+  }
+}
+
+/*
+  runs the next stage of the chunk being seeded, or else the next job. seeding
+  relies on no removal being in flight, they could clear the fresh column
+  fills, so it waits for propagation. false if there was nothing it could do
+*/
+static bool advanceJob() {
+  using namespace Lighting;
+
+  // the chunk was unloaded halfway
+  if(seed.lc != nullptr && !isLive(seed.lc)) {
+    seed.lc = nullptr;
+  }
+
+  if(seed.lc != nullptr) {
+    if(isRemoving()) {
+      return false;
+    }
+
+    if(seed.stage == SEED_COLUMNS) {
+      seedColumns(seed.lc, seed.bottoms);
+      seed.stage = SEED_SPREAD;
+    } else {
+      light_chunk_t* lc = seed.lc;
+      seed.lc = nullptr;
+      seedSpread(lc, seed.bottoms);
+      lc->chunk->seeding = false;
+    }
+
+    return true;
+  }
+
+  light_job_t job;
+
+  {
+    std::lock_guard<std::mutex> queueLock(queueMutex);
+
+    if(jobs.empty() || (isRemoving() && jobs.front().type == ADD_CHUNK)) {
+      return false;
+    }
+
+    job = jobs.front();
+    jobs.pop_front();
+  }
+
+  runJob(job);
+
+  return true;
+}
+
+static void workerLoop() {
+  using namespace Lighting;
+
+  Profiler::setThreadName("lighting");
+  bool working = false;
+
+  while(true) {
+    {
+      std::unique_lock<std::mutex> queueLock(queueMutex);
+
+      // propagation left over from the last batch carries on without waiting
+      queueCondition.wait(queueLock, [&working]() {
+        return !running || !jobs.empty() || working;
+      });
+
+      if(!running) {
+        return;
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      PROFILE_SCOPE("lighting")
+
+      // a single job stage or a batch of nodes per hold, neither is larger than a chunk's worth of work
+      if(!advanceJob()) {
+        propagate(NODES_PER_BATCH);
+      }
+
+      working = seed.lc != nullptr || isPropagating();
+
+      {
+        std::lock_guard<std::mutex> queueLock(queueMutex);
+
+        for(light_chunk_t* lc : dirtyChunks) {
+          lc->dirty = false;
+
+          // a half seeded chunk would be meshed dark, it is marked again once done
+          if(lc->chunk != nullptr && lc != seed.lc) {
+            changed.push_back(lc->pos);
+          }
+        }
+      }
+
+      dirtyChunks.clear();
+
+      if(!working && removedCount > 0) {
+        dropRemovedChunks();
+      }
+    }
+
+    // std::mutex isn't fair, give a waiting main thread the chance to take it
+    std::this_thread::yield();
+  }
+}
+
+void Lighting::init() {
+  running = true;
+  worker = std::thread(workerLoop);
+}
+
+void Lighting::free() {
+  {
+    std::lock_guard<std::mutex> queueLock(queueMutex);
+    running = false;
+  }
+
+  queueCondition.notify_all();
+
+  if(worker.joinable()) {
+    worker.join();
+  }
+
+  jobs.clear();
+  changed.clear();
+  sunAdd.clear();
+  sunRemove.clear();
+  blockAdd.clear();
+  blockRemove.clear();
+  dirtyChunks.clear();
+  seed.lc = nullptr;
+  lightChunks.clear();
+  removedCount = 0;
+}
+
+void Lighting::addChunk(Chunk* chunk) {
+  {
+    std::lock_guard<std::mutex> queueLock(queueMutex);
+    jobs.push_back({ADD_CHUNK, {chunk->x, chunk->y, chunk->z}, chunk});
+  }
+
+  queueCondition.notify_one();
+}
+
+void Lighting::removeChunk(vec3i pos) {
+  // waits for the worker to finish its batch, it may be reading the chunk
+  std::lock_guard<std::mutex> lock(mutex);
+
+  {
+    std::lock_guard<std::mutex> queueLock(queueMutex);
+
+    for(std::deque<light_job_t>::iterator it = jobs.begin(); it != jobs.end();) {
+      if(it->type == ADD_CHUNK && it->pos == pos) {
+        it = jobs.erase(it);
+      } else {
+        it++;
+      }
+    }
+  }
+
+  std::map<vec3i, light_chunk_t>::iterator it = lightChunks.find(pos);
+
+  if(it != lightChunks.end() && it->second.chunk != nullptr) {
+    it->second.chunk = nullptr;
+    removedCount++;
+  }
+}
+
+void Lighting::blockChanged(int x, int y, int z) {
+  {
+    std::lock_guard<std::mutex> queueLock(queueMutex);
+    jobs.push_back({BLOCK, {x, y, z}, nullptr});
+  }
+
+  queueCondition.notify_one();
+}
+
+void Lighting::chunkChanged(vec3i pos) {
+  {
+    std::lock_guard<std::mutex> queueLock(queueMutex);
+    jobs.push_back({RESEED_CHUNK, pos, nullptr});
+  }
+
+  queueCondition.notify_one();
+}
+
+void Lighting::collect(std::vector<vec3i>& out) {
+  std::lock_guard<std::mutex> queueLock(queueMutex);
+
+  out.insert(out.end(), changed.begin(), changed.end());
+  changed.clear();
+}
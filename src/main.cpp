@@ -16,15 +16,26 @@
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <stb_image.h>
 
 #include "common.h"
 #include "config.h"
 #include "camera.h"
 #include "chunk_manager.h"
+#include "chunk_renderer.h"
 #include "chunk.h"
 #include "skybox.h"
 #include "particle_manager.h"
+#include "raycast.h"
+#include "world.h"
+#include "fluids.h"
+#include "block_ticks.h"
+#include "world_storage.h"
+#include "chunk_stream.h"
+#include "asset_pack.h"
+#include "terrain.h"
+#include "allocators.h"
+#include "memory_tracker.h"
+#include "profiler.h"
 
 #include "gl/utils.h"
 #include "gl/texture_array.h"
@@ -33,18 +44,9 @@
 #include "glfw/window.h"
 #include "glfw/input.h"
 
-// textures
-#include "res/dirt.h"
-#include "res/stone.h"
-#include "res/bedrock.h"
-#include "res/sand.h"
-#include "res/grass_side.h"
-#include "res/glass.h"
-#include "res/snow.h"
-#include "res/water.h"
-#include "res/grass.h"
-#include "res/log.h"
-#include "res/log_top.h"
+#ifndef STDERR_FILENO
+#define STDERR_FILENO 2
+#endif
 
 #ifndef GIT_BRANCH
 #define GIT_BRANCH "unknown"
@@ -60,34 +62,29 @@
 
 #define REACH_DISTANCE 20.0f
 
-struct allocation_metrics_t {
-  uint totalAllocations = 0;
-};
-static allocation_metrics_t s_AllocationMetrics;
+double deltaTime;
+double lastFrame;
 
-void* operator new(size_t size) {
-  s_AllocationMetrics.totalAllocations++;
-  return malloc(size);
-}
+// the simulation advances in fixed ticks, whatever the frame rate
+const double TICK_RATE = 60.0;
+const double TICK_INTERVAL = 1.0 / TICK_RATE;
+// after a long stall the simulation falls behind instead of spiraling
+const int MAX_TICKS_PER_FRAME = 5;
 
-void operator delete(void* memory) {
-  s_AllocationMetrics.totalAllocations--;
-  free(memory);
-}
+double simulationTime = 0.0;
+double tickAccumulator = 0.0;
 
-double deltaTime;
-double lastFrame;
+// clicks since the last tick, a frame without a tick keeps them for the next one
+bool breakClicked = false;
+bool placeClicked = false;
+bool lampClicked = false;
 
 int windowWidth = 800;
 int windowHeight = 600;
 int windowedXPos, windowedYPos, windowedWidth, windowedHeight;
 
-GLFW::Window window(windowWidth, windowHeight, "cppvoxel");
-
-// config
-int viewDistance;
-int maxChunksGeneratedPerFrame;
-int maxChunksDeletedPerFrame;
+// created in main, after the terrain workers are already busy with the spawn area
+GLFW::Window* window;
 
 Camera camera(glm::vec3(0.0f, 150.0f, 0.0f));
 float lastX = (float)windowWidth / 2.0f;
@@ -100,11 +97,16 @@ bool cursorLocked = true;
 glm::mat4 projection = glm::mat4(1.0f);
 glm::mat4 cameraView;
 
+// must only use async-signal-safe calls
 void signalHandler(int signum) {
-  fprintf(stderr, "Interrupt signal %d received (pid: %d)\n", signum, getpid());
-  fprintf(stderr, "%s:%u (%s): %s", stackTraceFile.c_str(), stackTraceLine, stackTraceFile.c_str(), stackTraceName.c_str());
-
-  exit(signum);
+  writeSignalSafe(STDERR_FILENO, "Interrupt signal ");
+  writeSignalSafe(STDERR_FILENO, (long)signum);
+  writeSignalSafe(STDERR_FILENO, " received (pid: ");
+  writeSignalSafe(STDERR_FILENO, (long)getpid());
+  writeSignalSafe(STDERR_FILENO, ")\n");
+  dumpBreadcrumbs(STDERR_FILENO);
+
+  _exit(signum);
 }
 
 #ifdef DEBUG
@@ -223,7 +225,7 @@ void mouseCallback(double xpos, double ypos) {
 
 #ifdef MULTI_THREADING
 void updateChunksThread() {
-  while(!window.shouldClose()) {
+  while(!window->shouldClose()) {
     ChunkManager::update(pos, viewDistance + 1);
 
 #ifdef _WIN32
@@ -235,114 +237,95 @@ void updateChunksThread() {
 }
 #endif
 
-/* try 31?
-  if 'infinite' is 2 ^ 32
-  start your map at 2 ^ 32 / 2
-
-  - Verc
-*/
-bool VercidiumRayMarch(int* bx, int* by, int* bz, int* cx, int* cy, int* cz) {
-  float vx = camera.front.x;
-  float vy = camera.front.y;
-  float vz = camera.front.z;
-
-  float t = 0.0f;
+// breaks or places the block under the crosshair for the clicks queued since the last tick
+void applyClicks() {
+  if(breakClicked || placeClicked || lampClicked) {
+    Raycast::raycast_hit_t hit;
 
-  while(t < REACH_DISTANCE) {
-    float rayx = camera.position.x + vx * t;
-    float rayy = camera.position.y + vy * t;
-    float rayz = camera.position.z + vz * t;
+    if(Raycast::cast(camera.position, camera.front, REACH_DISTANCE, &hit)) {
+      // break the hit block or place against the face that was hit
+      vec3i target = hit.block;
 
-    std::shared_ptr<Chunk> chunk = ChunkManager::get({(int)floorf(rayx / CHUNK_SIZE), (int)floorf(rayy / CHUNK_SIZE), (int)floorf(rayz / CHUNK_SIZE)});
-
-    if(chunk != nullptr) {
-      int nx = abs(roundf(rayx));
-      int ny = abs(roundf(rayy));
-      int nz = abs(roundf(rayz));
-
-      block_t block = chunk->get(nx % CHUNK_SIZE, ny % CHUNK_SIZE, nz % CHUNK_SIZE);
+      if(!breakClicked) {
+        target.x += hit.normal.x;
+        target.y += hit.normal.y;
+        target.z += hit.normal.z;
+      }
 
-      if(block > 0) {
-        // printf("chunk: %d %d %d\n", chunk->x, chunk->y, chunk->z);
-        // printf("hit block %d at %d %d %d\n", block, nx % CHUNK_SIZE, ny % CHUNK_SIZE, nz % CHUNK_SIZE);
-        *bx = nx;
-        *by = ny;
-        *bz = nz;
-        *cx = chunk->x;
-        *cy = chunk->y;
-        *cz = chunk->z;
+      block_t block = breakClicked ? AIR : placeClicked ? DIRT : LAMP;
 
-        return true;
+      if(World::set(target.x, target.y, target.z, block)) {
+        ChunkStream::sendEdit(target.x, target.y, target.z, block);
       }
     }
-
-    t += 0.01f;
   }
 
-  return false;
+  breakClicked = false;
+  placeClicked = false;
+  lampClicked = false;
 }
 
-/* FIXME:
- * Use an array
- * Have texture IDs be constants
-*/
-uint8_t* loadTexture(int index) {
-  int width, height, nrChannels;
-  uint8_t* imageData;
-  printf("%d;", index);
-
-  switch(index) {
-    case 0:
-      imageData = stbi_load_from_memory(IMAGE_DIRT_BYTES, sizeof(IMAGE_DIRT_BYTES), &width, &height, &nrChannels, STBI_rgb_alpha);
-      break;
+// one fixed step of the simulation, input is sampled per tick so movement doesn't depend on the frame rate
+void tick() {
+  PROFILE_SCOPE("tick")
 
-    case 1:
-      imageData = stbi_load_from_memory(IMAGE_STONE_BYTES, sizeof(IMAGE_STONE_BYTES), &width, &height, &nrChannels, STBI_rgb_alpha);
-      break;
+  simulationTime += TICK_INTERVAL;
+  camera.beginTick();
 
-    case 2:
-      imageData = stbi_load_from_memory(IMAGE_BEDROCK_BYTES, sizeof(IMAGE_BEDROCK_BYTES), &width, &height, &nrChannels, STBI_rgb_alpha);
-      break;
+  camera.fast = Input::getKey(Input::Key::LEFT_SHIFT).down;
 
-    case 3:
-      imageData = stbi_load_from_memory(IMAGE_SAND_BYTES, sizeof(IMAGE_SAND_BYTES), &width, &height, &nrChannels, STBI_rgb_alpha);
-      break;
+  if(Input::getKey(Input::Key::W).down) {
+    camera.processKeyboard(FORWARD, (float)TICK_INTERVAL);
+  } else if(Input::getKey(Input::Key::S).down) {
+    camera.processKeyboard(BACKWARD, (float)TICK_INTERVAL);
+  }
 
-    case 4:
-      imageData = stbi_load_from_memory(IMAGE_GRASS_SIDE_BYTES, sizeof(IMAGE_GRASS_SIDE_BYTES), &width, &height, &nrChannels, STBI_rgb_alpha);
-      break;
+  if(Input::getKey(Input::Key::A).down) {
+    camera.processKeyboard(LEFT, (float)TICK_INTERVAL);
+  } else if(Input::getKey(Input::Key::D).down) {
+    camera.processKeyboard(RIGHT, (float)TICK_INTERVAL);
+  }
 
-    case 5:
-      imageData = stbi_load_from_memory(IMAGE_GLASS_BYTES, sizeof(IMAGE_GLASS_BYTES), &width, &height, &nrChannels, STBI_rgb_alpha);
-      break;
+  applyClicks();
 
-    case 6:
-      imageData = stbi_load_from_memory(IMAGE_SNOW_BYTES, sizeof(IMAGE_SNOW_BYTES), &width, &height, &nrChannels, STBI_rgb_alpha);
-      break;
+  ParticleManager::update(simulationTime, camera.position);
+  Fluids::tick();
+  BlockTicks::tick();
+}
 
-    case 7:
-      imageData = stbi_load_from_memory(IMAGE_WATER_BYTES, sizeof(IMAGE_WATER_BYTES), &width, &height, &nrChannels, STBI_rgb_alpha);
-      break;
+// builds the shaders and textures again, edited files in the override directory replace what was loaded
+void reloadAssets(GL::TextureArray** textureArray) {
+  AssetPack::asset_t textures;
 
-    case 8:
-      imageData = stbi_load_from_memory(IMAGE_GRASS_BYTES, sizeof(IMAGE_GRASS_BYTES), &width, &height, &nrChannels, STBI_rgb_alpha);
-      break;
+  if(AssetPack::get("textures", &textures)) {
+    delete *textureArray;
+    *textureArray = new GL::TextureArray(0, textures.data, textures.size);
+  } else {
+    fprintf(stderr, "%s: no textures to reload\n", __func__);
+  }
 
-    case 9:
-      imageData = stbi_load_from_memory(IMAGE_LOG_BYTES, sizeof(IMAGE_LOG_BYTES), &width, &height, &nrChannels, STBI_rgb_alpha);
-      break;
+  Skybox::reloadShader();
+  ChunkRenderer::reloadShader();
+  ParticleManager::reloadShader();
 
-    case 10:
-      imageData = stbi_load_from_memory(IMAGE_LOG_TOP_BYTES, sizeof(IMAGE_LOG_TOP_BYTES), &width, &height, &nrChannels, STBI_rgb_alpha);
-      break;
+  printf("assets reloaded\n");
+}
 
-    default:
-      fprintf(stderr, "f");
-      exit(-1);
-      break;
+// the settings that can change while running
+void applyConfig(Config& config, bool* vsync) {
+  int distance = config.getInt("viewDistance", 8);
+  maxChunksGeneratedPerFrame = config.getInt("maxChunksGeneratedPerFrame", 2);
+  maxChunksDeletedPerFrame = config.getInt("maxChunksDeletedPerFrame", 4);
+  bool newVsync = config.getBool("vsync", false);
+
+  if(distance != viewDistance) {
+    ChunkManager::setViewDistance(distance);
   }
 
-  return imageData;
+  if(newVsync != *vsync) {
+    *vsync = newVsync;
+    GLFW::enableVsync(*vsync);
+  }
 }
 
 int main(int argc, char** argv) {
@@ -355,6 +338,8 @@ int main(int argc, char** argv) {
 
   STACK_TRACE_PUSH("init")
 
+  Profiler::init();
+
   printf("== cppvoxel ==\n");
   printf("version: %s@%s@%s\n", GIT_BRANCH, GIT_TAG, GIT_HASH);
 
@@ -364,6 +349,8 @@ int main(int argc, char** argv) {
   printf("multithreading: disabled\n");
 #endif
 
+  Profiler::beginPhase("config");
+
   Config config("config.conf");
 
   printf("== Config ==\n");
@@ -371,6 +358,47 @@ int main(int argc, char** argv) {
   maxChunksGeneratedPerFrame = config.getInt("maxChunksGeneratedPerFrame", 2);
   maxChunksDeletedPerFrame = config.getInt("maxChunksDeletedPerFrame", 4);
   bool vsync = config.getBool("vsync", false);
+  hugePages = config.getBool("hugePages", false);
+  const char* worldPath = config.getString("world");
+
+  if(worldPath == NULL) {
+    worldPath = "world";
+  }
+
+  const char* assetsPath = config.getString("assets");
+
+  if(assetsPath == NULL) {
+    assetsPath = "assets.pak";
+  }
+
+  // files in the override directory are used instead of their packed copies, F6 reloads them
+  if(!AssetPack::open(assetsPath, config.getString("assetOverrides"))) {
+    return -1;
+  }
+
+  // a world server replaces local generation, otherwise a pregenerated world replaces it for every chunk it holds
+  const char* serverAddress = config.getString("server");
+  uint seed;
+
+  if(serverAddress != NULL && ChunkStream::connect(serverAddress)) {
+    Terrain::setSeed(ChunkStream::getSeed());
+  } else if(WorldStorage::open(worldPath, &seed)) {
+    Terrain::setSeed(seed);
+    printf("world: %s (seed %u)\n", worldPath, seed);
+  }
+
+  // the spawn area generates on the workers while the window, textures and shaders are set up
+  Profiler::beginPhase("spawn area requests");
+
+  pos.x = (int)floorf(camera.position.x / CHUNK_SIZE);
+  pos.y = (int)floorf(camera.position.y / CHUNK_SIZE);
+  pos.z = (int)floorf(camera.position.z / CHUNK_SIZE);
+
+  ChunkManager::prepare(pos);
+
+  Profiler::beginPhase("gl context");
+
+  window = new GLFW::Window(windowWidth, windowHeight, "cppvoxel");
 
   printf("== OpenGL ==\n");
   printf("version: %s\n", GL::getString(GL::VERSION));
@@ -388,9 +416,9 @@ int main(int argc, char** argv) {
   // printf("byte   : %lu\n", (long unsigned)sizeof(int8_t));
   // printf("ubyte  : %lu\n", (long unsigned)sizeof(uint8_t));
 
-  window.setMouseCallback(mouseCallback);
+  window->setMouseCallback(mouseCallback);
 
-  window.setCursorMode(GLFW::DISABLED);
+  window->setCursorMode(GLFW::DISABLED);
   GLFW::enableVsync(vsync);
 
   GL::init();
@@ -422,66 +450,82 @@ int main(int argc, char** argv) {
   GL::enable(GL::MULTISAMPLE);
   GL::setClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 
-  const int NUM_TEXTURES = 11;
-  const int TEXTURE_RES = 16;
+  Profiler::beginPhase("textures");
 
   printf("loading textures: ");
 
-  GL::TextureArray* textureArray = new GL::TextureArray(0, NUM_TEXTURES, TEXTURE_RES, loadTexture);
+  AssetPack::asset_t textures;
+
+  if(!AssetPack::get("textures", &textures)) {
+    fprintf(stderr, "%s: %s has no textures\n", __func__, assetsPath);
+    return -1;
+  }
+
+  GL::TextureArray* textureArray = new GL::TextureArray(0, textures.data, textures.size);
 
-  printf(" done!\n");
+  printf("done!\n");
+
+  Profiler::beginPhase("shaders");
 
   Skybox::init();
-  ChunkManager::init();
+  ChunkRenderer::init();
   ParticleManager::init();
 
   CATCH_OPENGL_ERROR
 
-  pos.x = (int)floorf(camera.position.x / CHUNK_SIZE);
-  pos.y = (int)floorf(camera.position.y / CHUNK_SIZE);
-  pos.z = (int)floorf(camera.position.z / CHUNK_SIZE);
+  Profiler::endPhase();
 
 #ifdef MULTI_THREADING
   std::thread chunkThread(updateChunksThread);
 #endif
 
   double currentTime;
+  lastFrame = GLFW::getTime();
+  bool firstFrameDrawn = false;
+  bool startupReported = false;
 
   unsigned short frames = 0;
   double lastPrintTime = GLFW::getTime();
 
   STACK_TRACE_PUSH("main loop")
 
-  while(!window.shouldClose()) {
+  while(!window->shouldClose()) {
+    // edits to the config file are applied live
+    if(config.poll()) {
+      printf("== Config reloaded ==\n");
+      applyConfig(config, &vsync);
+    }
+
     currentTime = GLFW::getTime();
     deltaTime = currentTime - lastFrame;
     lastFrame = currentTime;
     frames++;
 
     if(currentTime - lastPrintTime >= 1.0) {
-      printf("%.2fms (%dfps) %u chunks %u particles allocated %u allocations\n", 1000.0f / (float)frames, frames, (uint)ChunkManager::chunks.size(), (uint)ParticleManager::particles.size(),
-             s_AllocationMetrics.totalAllocations);
+      printf("%.2fms (%dfps) %u chunks %u particles allocated %llu allocations (%.2fMB) %llu allocations last frame\n", 1000.0f / (float)frames, frames, (uint)ChunkManager::chunks.size(),
+             ParticleManager::getLiveCount(), (unsigned long long)MemoryTracker::getLiveAllocations(), MemoryTracker::getLiveBytes() / 1048576.0,
+             (unsigned long long)MemoryTracker::getFrameAllocations());
       frames = 0;
       lastPrintTime += 1.0;
     }
 
     if(Input::getKey(Input::Key::F12).pressed) {
-      window.setShouldClose(true);
+      window->setShouldClose(true);
     }
 
     if(Input::getKey(Input::Key::ESCAPE).pressed) {
       if(cursorLocked) {
-        window.setCursorMode(GLFW::NORMAL);
+        window->setCursorMode(GLFW::NORMAL);
         firstMouse = true;
       } else {
-        window.setCursorMode(GLFW::DISABLED);
+        window->setCursorMode(GLFW::DISABLED);
       }
 
       cursorLocked = !cursorLocked;
     }
 
     if(Input::getKey(Input::Key::F11).pressed) {
-      window.setFullscreen(!window.getFullscreen());
+      window->setFullscreen(!window->getFullscreen());
     }
 
     if(Input::getKey(Input::Key::F10).pressed) {
@@ -489,39 +533,57 @@ int main(int argc, char** argv) {
       GLFW::enableVsync(vsync);
     }
 
+    if(Input::getKey(Input::Key::F2).pressed) {
+      Profiler::printSummary();
+    }
+
+    if(Input::getKey(Input::Key::F3).pressed) {
+      Profiler::writeTrace("trace.json");
+    }
+
     if(Input::getKey(Input::Key::F4).pressed) {
       printf("pos: x%.1f y%.1f z%.1f\n", camera.position.x, camera.position.y, camera.position.z);
     }
 
-    camera.fast = Input::getKey(Input::Key::LEFT_SHIFT).down;
+    if(Input::getKey(Input::Key::F5).pressed) {
+      MemoryTracker::printReport();
+    }
 
-    if(Input::getKey(Input::Key::W).down) {
-      camera.processKeyboard(FORWARD, deltaTime);
-    } else if(Input::getKey(Input::Key::S).down) {
-      camera.processKeyboard(BACKWARD, deltaTime);
+    if(Input::getKey(Input::Key::F6).pressed) {
+      reloadAssets(&textureArray);
     }
 
-    if(Input::getKey(Input::Key::A).down) {
-      camera.processKeyboard(LEFT, deltaTime);
-    } else if(Input::getKey(Input::Key::D).down) {
-      camera.processKeyboard(RIGHT, deltaTime);
+    if(Input::getKey(Input::Key::PAGE_UP).pressed) {
+      ChunkManager::setViewDistance(viewDistance + 1);
+      printf("view distance: %d\n", viewDistance);
     }
 
-    bool leftMouse = Input::getMosue(Input::MouseButton::LEFT);
-    bool rightMouse = Input::getMosue(Input::MouseButton::RIGHT);
+    if(Input::getKey(Input::Key::PAGE_DOWN).pressed && viewDistance > 1) {
+      ChunkManager::setViewDistance(viewDistance - 1);
+      printf("view distance: %d\n", viewDistance);
+    }
 
-    if(leftMouse || rightMouse) {
-      int hx, hy, hz, cx, cy, cz;
+    // one edit per click, holding a button doesn't repeat it
+    breakClicked |= Input::getMosue(Input::MouseButton::LEFT).pressed;
+    placeClicked |= Input::getMosue(Input::MouseButton::RIGHT).pressed;
+    lampClicked |= Input::getMosue(Input::MouseButton::MIDDLE).pressed;
 
-      if(VercidiumRayMarch(&hx, &hy, &hz, &cx, &cy, &cz)) {
-        std::shared_ptr<Chunk> chunk = ChunkManager::get({cx, cy, cz});
+    tickAccumulator += deltaTime;
+    int ticks = 0;
 
-        if(chunk != NULL) {
-          chunk->set(hx % CHUNK_SIZE, hy % CHUNK_SIZE, hz % CHUNK_SIZE, leftMouse ? 0 : 1);
-        }
-      }
+    while(tickAccumulator >= TICK_INTERVAL && ticks < MAX_TICKS_PER_FRAME) {
+      tick();
+      tickAccumulator -= TICK_INTERVAL;
+      ticks++;
     }
 
+    if(ticks == MAX_TICKS_PER_FRAME) {
+      tickAccumulator = MIN(tickAccumulator, TICK_INTERVAL);
+    }
+
+    // how far the rendered frame is between the last two ticks
+    float alpha = (float)(tickAccumulator / TICK_INTERVAL);
+
     pos.x = (int)floorf(camera.position.x / CHUNK_SIZE);
     pos.y = (int)floorf(camera.position.y / CHUNK_SIZE);
     pos.z = (int)floorf(camera.position.z / CHUNK_SIZE);
@@ -529,23 +591,42 @@ int main(int argc, char** argv) {
 #ifndef MULTI_THREADING
     ChunkManager::update(pos);
 #endif
-    ParticleManager::update(deltaTime, camera.position);
 
     GL::clear(GL::COLOR | GL::DEPTH);
 
-    window.getSize(&windowWidth, &windowHeight);
+    window->getSize(&windowWidth, &windowHeight);
     projection = glm::perspective(glm::radians(camera.fov), (float)windowWidth / (float)windowHeight, .1f, 10000.0f);
-    cameraView = camera.getViewMatrix();
+    cameraView = camera.getViewMatrix(alpha);
 
     Skybox::draw(projection, cameraView);
-    ChunkManager::draw(projection, cameraView);
-    ParticleManager::draw(projection, cameraView);
+    ChunkRenderer::draw(projection, cameraView);
+    ParticleManager::draw(projection, cameraView, simulationTime - (1.0 - alpha) * TICK_INTERVAL);
 
     CATCH_OPENGL_ERROR
 
     Input::update();
-    window.pollEvents();
-    window.swapBuffers();
+    window->pollEvents();
+
+    {
+      PROFILE_SCOPE("swap buffers")
+      window->swapBuffers();
+    }
+
+    // cold start latency, reported once every chunk in view is lit and meshed
+    if(!firstFrameDrawn) {
+      Profiler::markMilestone("first frame");
+      firstFrameDrawn = true;
+    }
+
+    if(!startupReported && ChunkRenderer::isViewComplete()) {
+      Profiler::markMilestone("full view radius");
+      Profiler::printStartup();
+      startupReported = true;
+    }
+
+    FrameArena::reset();
+    Profiler::endFrame();
+    MemoryTracker::endFrame();
   }
 
 #ifdef MULTI_THREADING
@@ -553,10 +634,24 @@ int main(int argc, char** argv) {
 #endif
 
   ParticleManager::free();
+  Fluids::free();
+  BlockTicks::free();
+  World::free();
+  ChunkRenderer::free();
   ChunkManager::free();
+  ChunkStream::disconnect();
+  WorldStorage::close();
   Skybox::free();
 
   delete textureArray;
+  AssetPack::close();
+
+  FrameArena::free();
+
+  Profiler::writeTrace("trace.json");
+  Profiler::free();
+
+  delete window;
 
   return 0;
 }
@@ -0,0 +1,231 @@
+#include "memory_tracker.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+/*
+  every tracked block is prefixed with a small header holding its size and
+  tag so frees can be attributed without the caller passing a size. the
+  header is 16 bytes to keep the returned pointer aligned like malloc's
+*/
+struct header_t {
+  size_t size;
+  MemoryTracker::Tag tag;
+};
+
+const static size_t HEADER_SIZE = 16;
+static_assert(sizeof(header_t) <= HEADER_SIZE, "allocation header does not fit");
+
+struct tag_counters_t {
+  std::atomic<uint64_t> allocations;
+  std::atomic<uint64_t> frees;
+  std::atomic<uint64_t> liveBytes;
+  std::atomic<uint64_t> totalBytes;
+};
+
+const static char* TAG_NAMES[MemoryTracker::TAG_COUNT] = {
+  "general",
+  "chunk storage",
+  "meshing",
+  "particles",
+  "gl wrappers"
+};
+
+namespace MemoryTracker {
+// zero initialized before any constructor runs, so allocations during static init are safe
+tag_counters_t counters[TAG_COUNT];
+std::atomic<uint64_t> sizeClasses[SIZE_CLASSES];
+
+thread_local Tag currentTag = GENERAL;
+
+// only touched by the thread calling endFrame
+uint64_t lastAllocations[TAG_COUNT];
+uint64_t frameAllocations[TAG_COUNT];
+}
+
+inline uint sizeClass(size_t size) {
+  if(size <= 1) {
+    return 0;
+  }
+
+  uint bits = 64 - __builtin_clzll((unsigned long long)(size - 1));
+
+  return MIN(bits, MemoryTracker::SIZE_CLASSES - 1);
+}
+
+void MemoryTracker::track(size_t size, Tag tag) {
+  tag_counters_t& c = counters[tag];
+  c.allocations.fetch_add(1, std::memory_order_relaxed);
+  c.liveBytes.fetch_add(size, std::memory_order_relaxed);
+  c.totalBytes.fetch_add(size, std::memory_order_relaxed);
+  sizeClasses[sizeClass(size)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void* MemoryTracker::allocate(size_t size, Tag tag) {
+  header_t* header = (header_t*)malloc(size + HEADER_SIZE);
+
+  if(header == NULL) {
+    return NULL;
+  }
+
+  header->size = size;
+  header->tag = tag;
+  track(size, tag);
+
+  return (uint8_t*)header + HEADER_SIZE;
+}
+
+void* MemoryTracker::allocate(size_t size) {
+  return allocate(size, currentTag);
+}
+
+void MemoryTracker::release(void* memory) {
+  if(memory == NULL) {
+    return;
+  }
+
+  header_t* header = (header_t*)((uint8_t*)memory - HEADER_SIZE);
+
+  tag_counters_t& c = counters[header->tag];
+  c.frees.fetch_add(1, std::memory_order_relaxed);
+  c.liveBytes.fetch_sub(header->size, std::memory_order_relaxed);
+
+  free(header);
+}
+
+MemoryTracker::Tag MemoryTracker::getTag() {
+  return currentTag;
+}
+
+MemoryTracker::Tag MemoryTracker::setTag(Tag tag) {
+  Tag previous = currentTag;
+  currentTag = tag;
+  return previous;
+}
+
+void MemoryTracker::endFrame() {
+  for(uint i = 0; i < TAG_COUNT; i++) {
+    uint64_t allocations = counters[i].allocations.load(std::memory_order_relaxed);
+    frameAllocations[i] = allocations - lastAllocations[i];
+    lastAllocations[i] = allocations;
+  }
+}
+
+uint64_t MemoryTracker::getFrameAllocations() {
+  uint64_t total = 0;
+
+  for(uint i = 0; i < TAG_COUNT; i++) {
+    total += frameAllocations[i];
+  }
+
+  return total;
+}
+
+uint64_t MemoryTracker::getLiveAllocations() {
+  uint64_t total = 0;
+
+  for(uint i = 0; i < TAG_COUNT; i++) {
+    total += counters[i].allocations.load(std::memory_order_relaxed) - counters[i].frees.load(std::memory_order_relaxed);
+  }
+
+  return total;
+}
+
+uint64_t MemoryTracker::getLiveBytes() {
+  uint64_t total = 0;
+
+  for(uint i = 0; i < TAG_COUNT; i++) {
+    total += counters[i].liveBytes.load(std::memory_order_relaxed);
+  }
+
+  return total;
+}
+
+MemoryTracker::tag_stats_t MemoryTracker::getTagStats(Tag tag) {
+  tag_counters_t& c = counters[tag];
+
+  return {
+    c.allocations.load(std::memory_order_relaxed),
+    c.frees.load(std::memory_order_relaxed),
+    c.liveBytes.load(std::memory_order_relaxed),
+    c.totalBytes.load(std::memory_order_relaxed),
+    frameAllocations[tag]
+  };
+}
+
+const char* MemoryTracker::getTagName(Tag tag) {
+  return tag < TAG_COUNT ? TAG_NAMES[tag] : "unknown";
+}
+
+void MemoryTracker::printReport() {
+  printf("== Memory ==\n");
+
+  for(uint i = 0; i < TAG_COUNT; i++) {
+    tag_stats_t stats = getTagStats((Tag)i);
+    printf("%s: %llu live (%.2fMB), %llu allocated (%.2fMB total), %llu last frame\n", getTagName((Tag)i), (unsigned long long)(stats.allocations - stats.frees), stats.liveBytes / 1048576.0,
+           (unsigned long long)stats.allocations, stats.totalBytes / 1048576.0, (unsigned long long)stats.frameAllocations);
+  }
+
+  printf("size classes:");
+
+  for(uint i = 0; i < SIZE_CLASSES; i++) {
+    printf(" %s%lluB:%llu", i == SIZE_CLASSES - 1 ? ">" : "<=", 1ull << (i == SIZE_CLASSES - 1 ? i - 1 : i), (unsigned long long)sizeClasses[i].load(std::memory_order_relaxed));
+  }
+
+  printf("\n");
+}
+
+void* operator new(size_t size) {
+  void* memory = MemoryTracker::allocate(size);
+
+  if(memory == NULL) {
+    throw std::bad_alloc();
+  }
+
+  return memory;
+}
+
+void* operator new[](size_t size) {
+  void* memory = MemoryTracker::allocate(size);
+
+  if(memory == NULL) {
+    throw std::bad_alloc();
+  }
+
+  return memory;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return MemoryTracker::allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return MemoryTracker::allocate(size);
+}
+
+// every delete variant has to be replaced, otherwise blocks would be freed without their header
+void operator delete(void* memory) noexcept {
+  MemoryTracker::release(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+  MemoryTracker::release(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+  MemoryTracker::release(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+  MemoryTracker::release(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+  MemoryTracker::release(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+  MemoryTracker::release(memory);
+}
@@ -0,0 +1,322 @@
+#include "net.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#endif
+
+// segments handed to one sendmsg call
+const uint MAX_SEND_SEGMENTS = 64;
+const size_t RECEIVE_SIZE = 64 * 1024;
+
+#ifndef _WIN32
+
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;
+#endif
+
+static bool setNonBlocking(int handle) {
+  int flags = fcntl(handle, F_GETFL, 0);
+  return flags != -1 && fcntl(handle, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+// fills in the socket address, returns its length or 0 if the address is invalid
+static socklen_t parseAddress(const char* address, sockaddr_storage* storage, int* family) {
+  memset(storage, 0, sizeof(sockaddr_storage));
+
+  if(strncmp(address, "tcp:", 4) == 0) {
+    int port = atoi(address + 4);
+
+    if(port <= 0 || port > 65535) {
+      fprintf(stderr, "%s: invalid port in %s\n", __func__, address);
+      return 0;
+    }
+
+    // loopback only, the protocol has no authentication
+    sockaddr_in* in = (sockaddr_in*)storage;
+    in->sin_family = AF_INET;
+    in->sin_port = htons((uint16_t)port);
+    in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    *family = AF_INET;
+
+    return sizeof(sockaddr_in);
+  }
+
+  sockaddr_un* un = (sockaddr_un*)storage;
+
+  if(strlen(address) >= sizeof(un->sun_path)) {
+    fprintf(stderr, "%s: socket path too long: %s\n", __func__, address);
+    return 0;
+  }
+
+  un->sun_family = AF_UNIX;
+  strcpy(un->sun_path, address);
+  *family = AF_UNIX;
+
+  return sizeof(sockaddr_un);
+}
+
+int Net::listen(const char* address) {
+  sockaddr_storage storage;
+  int family;
+  socklen_t length = parseAddress(address, &storage, &family);
+
+  if(length == 0) {
+    return -1;
+  }
+
+  int handle = socket(family, SOCK_STREAM, 0);
+
+  if(handle == -1) {
+    fprintf(stderr, "%s: socket failed: %s\n", __func__, strerror(errno));
+    return -1;
+  }
+
+  if(family == AF_INET) {
+    int reuse = 1;
+    setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  } else {
+    // a socket file left behind by a previous server
+    unlink(address);
+  }
+
+  if(bind(handle, (sockaddr*)&storage, length) == -1 || ::listen(handle, 16) == -1 || !setNonBlocking(handle)) {
+    fprintf(stderr, "%s: unable to listen on %s: %s\n", __func__, address, strerror(errno));
+    ::close(handle);
+    return -1;
+  }
+
+  return handle;
+}
+
+int Net::connect(const char* address) {
+  sockaddr_storage storage;
+  int family;
+  socklen_t length = parseAddress(address, &storage, &family);
+
+  if(length == 0) {
+    return -1;
+  }
+
+  int handle = socket(family, SOCK_STREAM, 0);
+
+  if(handle == -1) {
+    fprintf(stderr, "%s: socket failed: %s\n", __func__, strerror(errno));
+    return -1;
+  }
+
+  // blocking connect, the server is local
+  if(::connect(handle, (sockaddr*)&storage, length) == -1 || !setNonBlocking(handle)) {
+    fprintf(stderr, "%s: unable to connect to %s: %s\n", __func__, address, strerror(errno));
+    ::close(handle);
+    return -1;
+  }
+
+  if(family == AF_INET) {
+    int noDelay = 1;
+    setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+  }
+
+  return handle;
+}
+
+int Net::accept(int listener) {
+  int handle = ::accept(listener, NULL, NULL);
+
+  if(handle == -1) {
+    return -1;
+  }
+
+  if(!setNonBlocking(handle)) {
+    ::close(handle);
+    return -1;
+  }
+
+  int noDelay = 1;
+  setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+  return handle;
+}
+
+void Net::close(int handle) {
+  if(handle != -1) {
+    ::close(handle);
+  }
+}
+
+#else
+
+int Net::listen(const char* address) {
+  fprintf(stderr, "%s: sockets are not supported on windows yet\n", __func__);
+  return -1;
+}
+
+int Net::connect(const char* address) {
+  fprintf(stderr, "%s: sockets are not supported on windows yet\n", __func__);
+  return -1;
+}
+
+int Net::accept(int listener) {
+  return -1;
+}
+
+void Net::close(int handle) {}
+
+#endif
+
+Net::Connection::Connection(int _handle) {
+  handle = _handle;
+  readOffset = 0;
+  broken = false;
+}
+
+Net::Connection::~Connection() {
+  close(handle);
+}
+
+void Net::Connection::send(uint type, const uint8_t* data, size_t size) {
+  std::vector<uint8_t>* buffer = new std::vector<uint8_t>(HEADER_SIZE + size);
+
+  putU32(buffer->data(), type);
+  putU32(buffer->data() + 4, (uint)size);
+
+  if(size > 0) {
+    memcpy(buffer->data() + HEADER_SIZE, data, size);
+  }
+
+  queue.push_back({buffer_ptr(buffer), 0});
+}
+
+void Net::Connection::send(uint type, const uint8_t* head, size_t headSize, buffer_ptr payload) {
+  std::vector<uint8_t>* buffer = new std::vector<uint8_t>(HEADER_SIZE + headSize);
+
+  putU32(buffer->data(), type);
+  putU32(buffer->data() + 4, (uint)(headSize + payload->size()));
+  memcpy(buffer->data() + HEADER_SIZE, head, headSize);
+
+  queue.push_back({buffer_ptr(buffer), 0});
+  queue.push_back({payload, 0});
+}
+
+bool Net::Connection::flush() {
+#ifndef _WIN32
+
+  while(!queue.empty()) {
+    iovec segments[MAX_SEND_SEGMENTS];
+    uint count = 0;
+
+    for(std::deque<segment_t>::const_iterator it = queue.begin(); it != queue.end() && count < MAX_SEND_SEGMENTS; it++) {
+      segments[count].iov_base = (void*)(it->data->data() + it->offset);
+      segments[count].iov_len = it->data->size() - it->offset;
+      count++;
+    }
+
+    msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = segments;
+    message.msg_iovlen = count;
+
+    ssize_t written = sendmsg(handle, &message, SEND_FLAGS);
+
+    if(written == -1) {
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+
+    // drop what went out, the last segment may be partly written
+    size_t remaining = (size_t)written;
+
+    while(remaining > 0) {
+      segment_t& segment = queue.front();
+      size_t left = segment.data->size() - segment.offset;
+
+      if(remaining < left) {
+        segment.offset += remaining;
+        break;
+      }
+
+      remaining -= left;
+      queue.pop_front();
+    }
+  }
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool Net::Connection::receive() {
+  if(broken) {
+    return false;
+  }
+
+#ifndef _WIN32
+
+  // drop the messages already handed out
+  if(readOffset > 0) {
+    inbox.erase(inbox.begin(), inbox.begin() + readOffset);
+    readOffset = 0;
+  }
+
+  while(true) {
+    size_t size = inbox.size();
+    inbox.resize(size + RECEIVE_SIZE);
+
+    ssize_t received = recv(handle, inbox.data() + size, RECEIVE_SIZE, 0);
+
+    if(received <= 0) {
+      inbox.resize(size);
+
+      if(received == 0) {
+        return false;
+      }
+
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+
+    inbox.resize(size + received);
+  }
+
+#else
+  return false;
+#endif
+}
+
+bool Net::Connection::next(message_t* message) {
+  if(broken || inbox.size() - readOffset < HEADER_SIZE) {
+    return false;
+  }
+
+  const uint8_t* header = inbox.data() + readOffset;
+  size_t size = getU32(header + 4);
+
+  if(size > MAX_PAYLOAD_SIZE) {
+    fprintf(stderr, "%s: %zu byte message, closing the connection\n", __func__, size);
+    broken = true;
+    return false;
+  }
+
+  if(inbox.size() - readOffset < HEADER_SIZE + size) {
+    return false;
+  }
+
+  message->type = getU32(header);
+  message->data = header + HEADER_SIZE;
+  message->size = size;
+  readOffset += HEADER_SIZE + size;
+
+  return true;
+}
@@ -1,16 +1,18 @@
 #include "particle_manager.h"
 
 #include <stdio.h>
-
-#include "glfw/glfw.h"
+#include <stddef.h>
+#include <math.h>
 
 #include "gl/utils.h"
-#include "gl/instance_buffer.h"
 #include "gl/vao.h"
 #include "gl/buffer.h"
+#include "gl/instance_buffer.h"
+#include "gl/stream_buffer.h"
 
 #include "common.h"
-#include "timer.h"
+#include "memory_tracker.h"
+#include "profiler.h"
 
 const static uint RAIN_COLOR = (uint)(40 | (60 << 8) | (255 << 16) | (255 << 24));
 const static uint SNOW_COLOR = (uint)(255 | (255 << 8) | (255 << 16) | (255 << 24));
@@ -26,178 +28,250 @@ WeatherType weather;
 double timeToSpawnParticles;
 const double PARTICLE_SPAWN_INTERVAL = 0.05; // seconds
 
-uint lastUsedParticle = 0;
-uint findUnusedParticle() {
-  for(uint i = lastUsedParticle; i < (uint)ParticleManager::particles.size(); i++) {
-    if(ParticleManager::particles[i].life <= 0.0f) {
-      lastUsedParticle = i;
-      return i;
-    }
-  }
+// spawn records the gpu ring can hold, the oldest are dropped if it overflows
+const uint PARTICLE_CAPACITY = 16384;
+
+// spawn records that can be staged per frame, well above the largest burst
+const uint PARTICLE_STREAM_RECORDS = 1024;
+
+/*
+  times sent to the shader wrap around so they keep full float precision in
+  long sessions, the shader takes ages modulo the same period. must be far
+  longer than any particle life
+*/
+const double PARTICLE_TIME_WRAP = 4096.0;
+
+// camera facing quad, two triangles, expanded along the billboard axes in the vertex shader
+const static int8_t quad_vertices[] = {
+  -1, -1,
+    1, -1,
+    1,  1,
+    -1, -1,
+    1,  1,
+    -1,  1,
+  };
 
-  for(uint i = 0; i < lastUsedParticle; i++) {
-    if(ParticleManager::particles[i].life <= 0.0f) {
-      lastUsedParticle = i;
-      return i;
-    }
-  }
+// xorshift32, replaces the global rand() so particles don't share or lock libc state
+inline uint nextRandom(uint& state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
 
-  printf("resizing particles (%u;%u)\n", (uint)ParticleManager::particles.size(), lastUsedParticle);
-  lastUsedParticle = (uint)ParticleManager::particles.size();
-  ParticleManager::particles.resize(ParticleManager::particles.size() + 2048);
+// random integer in [0, range)
+inline uint randomRange(uint& state, uint range) {
+  return (uint)(((uint64_t)nextRandom(state) * range) >> 32);
+}
+
+namespace ParticleManager {
+uint randomState = 0x9e3779b9;
+
+GL::Shader* shader;
+int shaderProjectionLocation, shaderViewLocation, shaderTimeLocation;
+
+GL::VAO* vao;
+GL::InstanceBuffer* spawnBuffer;
+// new records are written here and copied into spawnBuffer on the gpu
+GL::StreamBuffer* spawnStream;
+
+/*
+  ring of spawn records, head and tail count every particle ever spawned,
+  slot = index % PARTICLE_CAPACITY. [tail, head) is the window still drawn,
+  expiry mirrors the ring so the tail can be advanced without gpu readback
+*/
+uint64_t head = 0;
+uint64_t tail = 0;
+std::vector<double> expiry;
+}
 
-  return lastUsedParticle;
+inline uint packHalf2(float a, float b) {
+  return glm::packHalf2x16(glm::vec2(a, b));
 }
 
-void respawnParticle(ParticleManager::particle_t& particle, glm::vec3 cameraPos) {
-  particle.pos = glm::vec3(
-                   (rand() % 1000) - 500,   // x
-                   250.0f - (rand() % 100), // y
-                   (rand() % 1000) - 500    // z
-                 ) + cameraPos;
+void spawnParticle(ParticleManager::particle_spawn_t& particle, glm::vec3 cameraPos, double time) {
+  uint& random = ParticleManager::randomState;
+
+  particle.origin = glm::vec3(
+                      (float)randomRange(random, 1000) - 500.0f, // x
+                      250.0f - (float)randomRange(random, 100),  // y
+                      (float)randomRange(random, 1000) - 500.0f  // z
+                    ) + cameraPos;
+  particle.spawnTime = (float)fmod(time, PARTICLE_TIME_WRAP);
+
+  float life;
 
   if(weather == RAIN) {
-    float size = (rand() % 11) / 100.0f + 0.1f;
-    particle.size = {size, size * 20.0f, size};
-    particle.life = 2.0f;
-    particle.speed = -300.0f;
+    float size = randomRange(random, 11) / 100.0f + 0.1f;
+    life = 2.0f;
+    particle.size = packHalf2(size, size * 20.0f);
+    particle.motion = packHalf2(-300.0f, life);
     particle.color = RAIN_COLOR;
   } else {
-    float size = (rand() % 11) / 100.0f + 0.2f;
-    particle.size = {size, size, size};
-    particle.life = 15.0f;
-    particle.speed = -25.0f;
+    float size = randomRange(random, 11) / 100.0f + 0.2f;
+    life = 15.0f;
+    particle.size = packHalf2(size, size);
+    particle.motion = packHalf2(-25.0f, life);
     particle.color = SNOW_COLOR;
   }
-}
 
-inline void setWeatherCycle() {
-  weather = (WeatherType)((rand() % 2) + 1);
-  timeToEndWeatherCycle = GLFW::getTime() + 10.0;
-  printf("weather changed to %d\n", weather);
+  ParticleManager::expiry[ParticleManager::head % PARTICLE_CAPACITY] = time + life;
+  ParticleManager::head++;
 }
 
-inline glm::mat4 particleMatrix(glm::vec3 scale, glm::vec3 position) {
-  return {
-    scale.x, 0.0f, 0.0f, 0.0f,
-    0.0f, scale.y, 0.0f, 0.0f,
-    0.0f, 0.0f, scale.z, 0.0f,
-    position.x, position.y, position.z, 1.0f
-  };
-}
+// writes the records straight into the stream buffer and copies them into their ring slots, two copies when wrapping
+void spawnParticles(uint amount, glm::vec3 cameraPos, double time) {
+  using namespace ParticleManager;
 
-namespace ParticleManager {
-std::vector<particle_t> particles;
+  particle_spawn_t* records = (particle_spawn_t*)spawnStream->map(amount * sizeof(particle_spawn_t));
 
-GL::Shader* shader;
-int shaderProjectionLocation, shaderViewLocation;
+  // weather is cosmetic, a burst that doesn't fit this frame is dropped
+  if(records == nullptr) {
+    return;
+  }
 
-GL::InstanceBuffer<uint>* colorInstanceBuffer;
-GL::InstanceBuffer<glm::mat4>* matrixInstanceBuffer;
+  uint64_t first = head;
 
-GL::VAO* vao;
-uint particlesToDraw;
+  for(uint i = 0; i < amount; i++) {
+    spawnParticle(records[i], cameraPos, time);
+  }
+
+  size_t offset = spawnStream->commit();
+
+  while(first < head) {
+    uint slot = (uint)(first % PARTICLE_CAPACITY);
+    uint count = (uint)MIN(head - first, (uint64_t)(PARTICLE_CAPACITY - slot));
+
+    spawnBuffer->copy(spawnStream->getHandle(), offset, slot, count);
+
+    offset += count * sizeof(particle_spawn_t);
+    first += count;
+  }
 }
 
-void ParticleManager::init() {
-  // pre-allocate particles
-  particles.resize(16380);
+inline void setWeatherCycle(double time) {
+  weather = (WeatherType)(randomRange(ParticleManager::randomState, 2) + 1);
+  timeToEndWeatherCycle = time + 10.0;
+  printf("weather changed to %d\n", weather);
+}
 
-  shader = new GL::Shader(GL::Shaders::particle);
+static void loadShader() {
+  using namespace ParticleManager;
+
+  shader = new GL::Shader("particle");
   shader->use();
   shaderProjectionLocation = shader->getUniformLocation("projection");
   shaderViewLocation = shader->getUniformLocation("view");
+  shaderTimeLocation = shader->getUniformLocation("time");
+  shader->setFloat("time_wrap", (float)PARTICLE_TIME_WRAP);
+}
+
+void ParticleManager::init() {
+  MEMORY_TAG(MemoryTracker::PARTICLES)
 
-  setWeatherCycle();
+  expiry.resize(PARTICLE_CAPACITY);
+  head = tail = 0;
+
+  loadShader();
+
+  // the simulation clock starts at zero
+  setWeatherCycle(0.0);
 
   vao = new GL::VAO();
   GL::Buffer<GL::ARRAY>* vbo = new GL::Buffer<GL::ARRAY>();
 
   vao->bind();
-  vbo->data(sizeof(cube_vertices), cube_vertices);
-  vao->attrib<int8_t>(0, 4, GL::BYTE, 0);
+  vbo->data(sizeof(quad_vertices), quad_vertices);
+  vao->attrib<int8_t>(0, 2, GL::BYTE, 0);
 
   GL::VAO::unbind();
   delete vbo;
 
-  colorInstanceBuffer = new GL::InstanceBuffer<uint>(vao, particles.size(), 1);
-  matrixInstanceBuffer = new GL::InstanceBuffer<glm::mat4>(vao, particles.size(), 2);
+  spawnBuffer = new GL::InstanceBuffer(vao, PARTICLE_CAPACITY, sizeof(particle_spawn_t), {
+    {1, 4, GL::FLOAT, false, offsetof(particle_spawn_t, origin)}, // origin and spawn time
+    {2, 4, GL::HALF_FLOAT, false, offsetof(particle_spawn_t, size)}, // size, speed and life
+    {3, 4, GL::UNSIGNED_BYTE, true, offsetof(particle_spawn_t, color)}
+  });
+  spawnStream = new GL::StreamBuffer(PARTICLE_STREAM_RECORDS * sizeof(particle_spawn_t));
 
-  timeToSpawnParticles = GLFW::getTime();
+  timeToSpawnParticles = 0.0;
 }
 
 void ParticleManager::free() {
-  particles.clear();
-  particles.shrink_to_fit();
+  expiry.clear();
+  expiry.shrink_to_fit();
 
   delete vao;
-  delete colorInstanceBuffer;
-  delete matrixInstanceBuffer;
+  delete spawnBuffer;
+  delete spawnStream;
   delete shader;
 }
 
-void ParticleManager::update(double delta, glm::vec3 cameraPos) {
-  if(GLFW::getTime() > timeToEndWeatherCycle) {
-    setWeatherCycle();
+void ParticleManager::reloadShader() {
+  delete shader;
+  loadShader();
+}
+
+void ParticleManager::update(double time, glm::vec3 cameraPos) {
+  PROFILE_SCOPE("particle update")
+  MEMORY_TAG(MemoryTracker::PARTICLES)
+
+  if(time > timeToEndWeatherCycle) {
+    setWeatherCycle(time);
   }
 
-  if(weather != NONE && timeToSpawnParticles <= GLFW::getTime()) {
+  if(weather != NONE && timeToSpawnParticles <= time) {
     timeToSpawnParticles += PARTICLE_SPAWN_INTERVAL;
     uint8_t amount = weather == RAIN ? 100 : 15;
 
-    for(uint i = 0; i < amount; i++) {
-      respawnParticle(particles[findUnusedParticle()], cameraPos);
-    }
+    spawnParticles(amount, cameraPos, time);
   }
 
-  colorInstanceBuffer->expand(particles.size());
-  matrixInstanceBuffer->expand(particles.size());
-
-  uint* colorPtr;
-  glm::mat4* matrixPtr;
-
-#ifdef PRINT_TIMING
-  {
-    Timer timer;
-#endif
-
-    colorInstanceBuffer->bind();
-    colorPtr = GL::mapBuffer<uint>();
-    matrixInstanceBuffer->bind();
-    matrixPtr = GL::mapBuffer<glm::mat4>();
+  // the ring overwrote the oldest records
+  if(head - tail > PARTICLE_CAPACITY) {
+    tail = head - PARTICLE_CAPACITY;
+  }
 
-#ifdef PRINT_TIMING
-    printf("map particle buffers: %u particles ", particlesToDraw);
+  // retire expired records from the tail, anything expired behind a live one is hidden by the shader
+  while(tail < head && expiry[tail % PARTICLE_CAPACITY] <= time) {
+    tail++;
   }
-#endif
+}
 
-  uint bufferIndex = 0;
+void ParticleManager::draw(glm::mat4 projection, glm::mat4 view, double time) {
+  PROFILE_SCOPE("particle draw")
 
-  for(particle_t& p : particles) {
-    p.life -= (float)delta;
+  // several ticks can stage spawns between two frames, the regions only turn over per frame
+  spawnStream->endFrame();
 
-    if(p.life > 0.0f) {
-      p.pos += glm::vec3(0.0f, p.speed * (float)delta, 0.0f);
+  uint count = getLiveCount();
 
-      // write directly to memory 😬
-      colorPtr[bufferIndex] = p.color;
-      matrixPtr[bufferIndex++] = particleMatrix(p.size, p.pos);
-    }
+  if(count == 0) {
+    return;
   }
 
-  particlesToDraw = bufferIndex;
-
-  colorInstanceBuffer->bind();
-  GL::unmapBuffer();
-  matrixInstanceBuffer->bind();
-  GL::unmapBuffer();
-}
-
-void ParticleManager::draw(glm::mat4 projection, glm::mat4 view) {
   shader->use();
   shader->setMat4(shaderProjectionLocation, projection);
   shader->setMat4(shaderViewLocation, view);
+  shader->setFloat(shaderTimeLocation, (float)fmod(time, PARTICLE_TIME_WRAP));
 
   vao->bind();
-  GL::drawInstanced(48, particlesToDraw);
+
+  uint slot = (uint)(tail % PARTICLE_CAPACITY);
+  uint firstCount = MIN(count, PARTICLE_CAPACITY - slot);
+
+  spawnBuffer->setBaseInstance(slot);
+  GL::drawInstanced(6, firstCount);
+
+  // the live window wraps around the end of the ring
+  if(firstCount < count) {
+    spawnBuffer->setBaseInstance(0);
+    GL::drawInstanced(6, count - firstCount);
+  }
+
+  GL::VAO::unbind();
+}
+
+uint ParticleManager::getLiveCount() {
+  return (uint)(head - tail);
 }
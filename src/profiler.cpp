@@ -0,0 +1,300 @@
+#include "profiler.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+/*
+  every thread owns a fixed ring of events which only it writes to, the head
+  is published with a release store so the main thread can read finished
+  events without locking. the mutex only guards the list of buffers, which
+  changes when a thread records its first event
+*/
+struct thread_buffer_t {
+  Profiler::event_t events[Profiler::EVENT_BUFFER_SIZE];
+  std::atomic<uint64_t> head;
+  uint64_t consumed;
+  uint id;
+  const char* name;
+};
+
+namespace Profiler {
+std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+std::mutex buffersMutex;
+std::vector<thread_buffer_t*> buffers;
+
+thread_local thread_buffer_t* threadBuffer = nullptr;
+thread_local uint16_t threadDepth = 0;
+
+frame_t frames[FRAME_HISTORY];
+uint frameIndex = 0;
+uint framesRecorded = 0;
+uint64_t frameStart = 0;
+
+/*
+  cpu time is the whole process, so a phase that overlaps with worker
+  threads shows more cpu than wall time
+*/
+struct phase_t {
+  const char* name;
+  uint64_t wallStart, wallEnd;
+  clock_t cpuStart, cpuEnd;
+};
+
+struct milestone_t {
+  const char* name;
+  uint64_t time;
+};
+
+std::vector<phase_t> phases;
+std::vector<milestone_t> milestones;
+bool phaseOpen = false;
+}
+
+static thread_buffer_t* getThreadBuffer() {
+  if(Profiler::threadBuffer == nullptr) {
+    thread_buffer_t* buffer = new thread_buffer_t();
+    buffer->head.store(0, std::memory_order_relaxed);
+    buffer->consumed = 0;
+    buffer->name = nullptr;
+
+    std::lock_guard<std::mutex> lock(Profiler::buffersMutex);
+    buffer->id = (uint)Profiler::buffers.size();
+    Profiler::buffers.push_back(buffer);
+    Profiler::threadBuffer = buffer;
+  }
+
+  return Profiler::threadBuffer;
+}
+
+// adds time to a frame, merging scopes with the same name
+static void accumulate(Profiler::frame_t& frame, const char* name, uint16_t depth, uint calls, uint64_t time) {
+  for(uint i = 0; i < frame.scopeCount; i++) {
+    Profiler::scope_stats_t& scope = frame.scopes[i];
+
+    if(scope.name == name) {
+      scope.calls += calls;
+      scope.time += time;
+      return;
+    }
+  }
+
+  if(frame.scopeCount == Profiler::MAX_FRAME_SCOPES) {
+    return;
+  }
+
+  frame.scopes[frame.scopeCount++] = {name, depth, calls, time};
+}
+
+// writes a string literal as a json string
+static void writeJsonString(FILE* file, const char* str) {
+  fputc('"', file);
+
+  for(; *str; str++) {
+    if(*str == '"' || *str == '\\') {
+      fputc('\\', file);
+    }
+
+    fputc(*str, file);
+  }
+
+  fputc('"', file);
+}
+
+void Profiler::init() {
+  startTime = std::chrono::steady_clock::now();
+  frameStart = 0;
+  setThreadName("main");
+}
+
+void Profiler::free() {
+  std::lock_guard<std::mutex> lock(buffersMutex);
+
+  for(thread_buffer_t* buffer : buffers) {
+    delete buffer;
+  }
+
+  buffers.clear();
+  threadBuffer = nullptr;
+}
+
+uint64_t Profiler::now() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void Profiler::setThreadName(const char* name) {
+  getThreadBuffer()->name = name;
+}
+
+void Profiler::record(const char* name, uint64_t start, uint64_t end, uint16_t depth) {
+  thread_buffer_t* buffer = getThreadBuffer();
+  uint64_t head = buffer->head.load(std::memory_order_relaxed);
+
+  event_t& event = buffer->events[head & (EVENT_BUFFER_SIZE - 1)];
+  event.name = name;
+  event.start = start;
+  event.end = end;
+  event.depth = depth;
+
+  buffer->head.store(head + 1, std::memory_order_release);
+}
+
+uint16_t Profiler::pushDepth() {
+  return threadDepth++;
+}
+
+void Profiler::popDepth() {
+  threadDepth--;
+}
+
+void Profiler::endFrame() {
+  frame_t& frame = frames[frameIndex];
+  frame.start = frameStart;
+  frame.end = now();
+  frame.scopeCount = 0;
+
+  {
+    std::lock_guard<std::mutex> lock(buffersMutex);
+
+    for(thread_buffer_t* buffer : buffers) {
+      uint64_t head = buffer->head.load(std::memory_order_acquire);
+
+      // anything older than one full ring has already been overwritten
+      if(head - buffer->consumed > EVENT_BUFFER_SIZE) {
+        buffer->consumed = head - EVENT_BUFFER_SIZE;
+      }
+
+      for(uint64_t i = buffer->consumed; i < head; i++) {
+        const event_t& event = buffer->events[i & (EVENT_BUFFER_SIZE - 1)];
+        accumulate(frame, event.name, event.depth, 1, event.end - event.start);
+      }
+
+      buffer->consumed = head;
+    }
+  }
+
+  frameStart = frame.end;
+  frameIndex = (frameIndex + 1) % FRAME_HISTORY;
+
+  if(framesRecorded < FRAME_HISTORY) {
+    framesRecorded++;
+  }
+}
+
+const Profiler::frame_t& Profiler::getFrame(uint framesAgo) {
+  return frames[(frameIndex + FRAME_HISTORY - 1 - (framesAgo % FRAME_HISTORY)) % FRAME_HISTORY];
+}
+
+void Profiler::printSummary() {
+  if(framesRecorded == 0) {
+    return;
+  }
+
+  frame_t total;
+  total.scopeCount = 0;
+  uint64_t frameTime = 0;
+
+  for(uint i = 0; i < framesRecorded; i++) {
+    const frame_t& frame = getFrame(i);
+    frameTime += frame.end - frame.start;
+
+    for(uint j = 0; j < frame.scopeCount; j++) {
+      const scope_stats_t& scope = frame.scopes[j];
+      accumulate(total, scope.name, scope.depth, scope.calls, scope.time);
+    }
+  }
+
+  printf("== Profile (%u frames) ==\n", framesRecorded);
+  printf("frame: %.3fms\n", frameTime / (double)framesRecorded * 1e-6);
+
+  for(uint i = 0; i < total.scopeCount; i++) {
+    const scope_stats_t& scope = total.scopes[i];
+    printf("%*s%s: %.3fms (%.1f calls)\n", scope.depth * 2, "", scope.name, scope.time / (double)framesRecorded * 1e-6, scope.calls / (double)framesRecorded);
+  }
+}
+
+bool Profiler::writeTrace(const char* path) {
+  FILE* file = fopen(path, "w");
+
+  if(file == NULL) {
+    fprintf(stderr, "%s: unable to open %s\n", __func__, path);
+    return false;
+  }
+
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  bool first = true;
+  uint events = 0;
+
+  std::lock_guard<std::mutex> lock(buffersMutex);
+
+  for(thread_buffer_t* buffer : buffers) {
+    if(buffer->name != nullptr) {
+      fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", first ? "" : ",\n", buffer->id);
+      writeJsonString(file, buffer->name);
+      fprintf(file, "}}");
+      first = false;
+    }
+
+    uint64_t head = buffer->head.load(std::memory_order_acquire);
+    // leave some slack at the tail since the owning thread may be overwriting it right now
+    uint64_t tail = head > EVENT_BUFFER_SIZE - 1024 ? head - (EVENT_BUFFER_SIZE - 1024) : 0;
+
+    for(uint64_t i = tail; i < head; i++) {
+      const event_t& event = buffer->events[i & (EVENT_BUFFER_SIZE - 1)];
+
+      fprintf(file, "%s{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"name\":", first ? "" : ",\n", buffer->id, event.start * 1e-3, (event.end - event.start) * 1e-3);
+      writeJsonString(file, event.name);
+      fputc('}', file);
+      first = false;
+      events++;
+    }
+  }
+
+  fprintf(file, "\n]}\n");
+  fclose(file);
+
+  printf("wrote %u profiler events to %s\n", events, path);
+
+  return true;
+}
+
+void Profiler::beginPhase(const char* name) {
+  endPhase();
+
+  phases.push_back({name, now(), 0, clock(), 0});
+  phaseOpen = true;
+}
+
+void Profiler::endPhase() {
+  if(!phaseOpen) {
+    return;
+  }
+
+  phase_t& phase = phases.back();
+  phase.wallEnd = now();
+  phase.cpuEnd = clock();
+  phaseOpen = false;
+
+  // shows up in the trace next to the scopes recorded during the phase
+  record(phase.name, phase.wallStart, phase.wallEnd, threadDepth);
+}
+
+void Profiler::markMilestone(const char* name) {
+  milestones.push_back({name, now()});
+}
+
+void Profiler::printStartup() {
+  printf("== Startup ==\n");
+
+  for(const phase_t& phase : phases) {
+    printf("%s: %.1fms wall, %.1fms cpu\n", phase.name, (phase.wallEnd - phase.wallStart) * 1e-6, (phase.cpuEnd - phase.cpuStart) * 1000.0 / CLOCKS_PER_SEC);
+  }
+
+  for(const milestone_t& milestone : milestones) {
+    printf("%s after %.1fms\n", milestone.name, milestone.time * 1e-6);
+  }
+}
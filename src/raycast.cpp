@@ -0,0 +1,187 @@
+#include "raycast.h"
+
+#include <math.h>
+#include <float.h>
+#include <memory>
+
+#include "chunk.h"
+#include "chunk_manager.h"
+#include "profiler.h"
+
+// last chunk looked up, consecutive blocks along a ray are nearly always in the same one
+struct chunk_cache_t {
+  vec3i pos;
+  bool valid;
+  std::shared_ptr<Chunk> chunk;
+};
+
+inline Chunk* getChunk(chunk_cache_t& cache, vec3i pos) {
+  if(!cache.valid || cache.pos != pos) {
+    cache.pos = pos;
+    cache.chunk = ChunkManager::get(pos);
+    cache.valid = true;
+  }
+
+  return cache.chunk.get();
+}
+
+inline int floorToCell(int v, int size) {
+  return (v < 0 ? v - (size - 1) : v) / size * size;
+}
+
+/*
+  state of the walk, positions are relative to the origin in doubles so the
+  boundary distances stay exact far away from the world origin
+*/
+struct walk_t {
+  double origin[3];
+  double direction[3];
+  int voxel[3];
+  int step[3];
+  double tDelta[3];
+  double tMax[3];
+};
+
+inline void resetBoundaries(walk_t& walk) {
+  for(uint i = 0; i < 3; i++) {
+    if(walk.step[i] == 0) {
+      walk.tMax[i] = DBL_MAX;
+      continue;
+    }
+
+    double boundary = walk.voxel[i] + (walk.step[i] > 0 ? 1 : 0);
+    walk.tMax[i] = (boundary - walk.origin[i]) / walk.direction[i];
+  }
+}
+
+/*
+  jumps to the first block past the cube of the given size containing the
+  current block, returns the distance it was entered at and the axis crossed
+*/
+inline double skipCell(walk_t& walk, int size, uint* axis) {
+  int cellMin[3];
+  double tExit = DBL_MAX;
+
+  for(uint i = 0; i < 3; i++) {
+    cellMin[i] = floorToCell(walk.voxel[i], size);
+
+    if(walk.step[i] == 0) {
+      continue;
+    }
+
+    double boundary = cellMin[i] + (walk.step[i] > 0 ? size : 0);
+    double t = (boundary - walk.origin[i]) / walk.direction[i];
+
+    if(t < tExit) {
+      tExit = t;
+      *axis = i;
+    }
+  }
+
+  for(uint i = 0; i < 3; i++) {
+    if(i == *axis) {
+      walk.voxel[i] = walk.step[i] > 0 ? cellMin[i] + size : cellMin[i] - 1;
+    } else {
+      // the exit face bounds the other axes to the cell, clamping hides rounding at corners
+      int v = (int)floor(walk.origin[i] + walk.direction[i] * tExit);
+      walk.voxel[i] = MAX(cellMin[i], MIN(v, cellMin[i] + size - 1));
+    }
+  }
+
+  resetBoundaries(walk);
+
+  return tExit;
+}
+
+static bool castRay(chunk_cache_t& cache, glm::vec3 origin, glm::vec3 direction, float maxDistance, Raycast::raycast_hit_t* hit) {
+  float length = glm::length(direction);
+
+  if(length == 0.0f) {
+    return false;
+  }
+
+  walk_t walk;
+
+  for(uint i = 0; i < 3; i++) {
+    walk.origin[i] = origin[i];
+    walk.direction[i] = direction[i] / length;
+    walk.voxel[i] = (int)floor(walk.origin[i]);
+    walk.step[i] = walk.direction[i] > 0 ? 1 : walk.direction[i] < 0 ? -1 : 0;
+    walk.tDelta[i] = walk.step[i] != 0 ? fabs(1.0 / walk.direction[i]) : DBL_MAX;
+  }
+
+  resetBoundaries(walk);
+
+  double t = 0.0;
+  int axis = -1; // axis crossed to enter the current block, -1 for the starting block
+
+  while(t <= maxDistance) {
+    vec3i chunkPos = {toChunkCoord(walk.voxel[0]), toChunkCoord(walk.voxel[1]), toChunkCoord(walk.voxel[2])};
+    Chunk* chunk = getChunk(cache, chunkPos);
+    uint skipAxis = 0;
+
+    if(chunk == nullptr || chunk->empty) {
+      t = skipCell(walk, CHUNK_SIZE, &skipAxis);
+      axis = (int)skipAxis;
+      continue;
+    }
+
+    uint8_t lx = toLocalCoord(walk.voxel[0]);
+    uint8_t ly = toLocalCoord(walk.voxel[1]);
+    uint8_t lz = toLocalCoord(walk.voxel[2]);
+
+    if(chunk->isRegionEmpty(lx, ly, lz)) {
+      t = skipCell(walk, CHUNK_REGION_SIZE, &skipAxis);
+      axis = (int)skipAxis;
+      continue;
+    }
+
+    block_t block = chunk->get(lx, ly, lz);
+
+    if(block != AIR) {
+      hit->block = {walk.voxel[0], walk.voxel[1], walk.voxel[2]};
+      hit->normal = {0, 0, 0};
+
+      if(axis == 0) {
+        hit->normal.x = -walk.step[0];
+      } else if(axis == 1) {
+        hit->normal.y = -walk.step[1];
+      } else if(axis == 2) {
+        hit->normal.z = -walk.step[2];
+      }
+
+      hit->type = block;
+      hit->distance = (float)t;
+
+      return true;
+    }
+
+    // step into the neighbor whose boundary is closest
+    axis = walk.tMax[0] < walk.tMax[1] ? (walk.tMax[0] < walk.tMax[2] ? 0 : 2) : (walk.tMax[1] < walk.tMax[2] ? 1 : 2);
+    t = walk.tMax[axis];
+    walk.voxel[axis] += walk.step[axis];
+    walk.tMax[axis] += walk.tDelta[axis];
+  }
+
+  return false;
+}
+
+bool Raycast::cast(glm::vec3 origin, glm::vec3 direction, float maxDistance, raycast_hit_t* hit) {
+  PROFILE_SCOPE("raycast")
+
+  chunk_cache_t cache;
+  cache.valid = false;
+
+  return castRay(cache, origin, direction, maxDistance, hit);
+}
+
+void Raycast::castBatch(const ray_t* rays, uint count, raycast_hit_t* hits, bool* results) {
+  PROFILE_SCOPE("raycast batch")
+
+  chunk_cache_t cache;
+  cache.valid = false;
+
+  for(uint i = 0; i < count; i++) {
+    results[i] = castRay(cache, rays[i].origin, rays[i].direction, rays[i].maxDistance, &hits[i]);
+  }
+}
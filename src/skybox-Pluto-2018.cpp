@@ -5,6 +5,8 @@
 #include "gl/vao.h"
 #include "gl/buffer.h"
 
+#include "profiler.h"
+
 namespace Skybox {
 GL::Shader* shader;
 int shaderProjectionLocation, shaderViewLocation;
@@ -12,11 +14,17 @@ int shaderProjectionLocation, shaderViewLocation;
 GL::VAO* vao;
 }
 
-void Skybox::init() {
-  shader = new GL::Shader(GL::Shaders::skybox);
+static void loadShader() {
+  using namespace Skybox;
+
+  shader = new GL::Shader("skybox");
   shader->use();
   shaderProjectionLocation = shader->getUniformLocation("projection");
   shaderViewLocation = shader->getUniformLocation("view");
+}
+
+void Skybox::init() {
+  loadShader();
 
   vao = new GL::VAO();
   GL::Buffer<GL::ARRAY>* vbo = new GL::Buffer<GL::ARRAY>();
@@ -34,7 +42,14 @@ void Skybox::free() {
   delete shader;
 }
 
+void Skybox::reloadShader() {
+  delete shader;
+  loadShader();
+}
+
 void Skybox::draw(glm::mat4 projection, glm::mat4 view) {
+  PROFILE_SCOPE("skybox draw")
+
   GL::setDepthTest(GL::LEQUAL);
   GL::setCullFace(GL::FRONT);
 
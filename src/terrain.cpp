@@ -0,0 +1,810 @@
+#include "terrain.h"
+
+#include <string.h>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/noise.hpp>
+
+#include "profiler.h"
+
+#define WATER_LEVEL 57
+
+// caves stay this far below the surface, so the ground features stand on is never carved
+#define CAVE_DEPTH 5
+
+// most blocks the density noise moves the surface up or down, creating overhangs
+#define OVERHANG_AMPLITUDE 12
+
+// 3d noise is sampled every LATTICE_STEP blocks, LATTICE_SIZE^3 samples per chunk
+#define LATTICE_STEP 4
+#define LATTICE_SIZE (CHUNK_SIZE / LATTICE_STEP)
+#define LATTICE_GRID (LATTICE_SIZE + 1)
+
+enum NoiseField : uint8_t {
+  OVERHANG_FIELD = 0,
+  CAVE_FIELD,
+  FIELD_COUNT
+};
+
+// lattice points owned by one chunk position, the ones on its far faces belong to the neighbors
+struct lattice_t {
+  float samples[FIELD_COUNT][LATTICE_SIZE * LATTICE_SIZE * LATTICE_SIZE];
+};
+
+// one field around a chunk including the far faces, ready for interpolation
+struct lattice_grid_t {
+  float samples[LATTICE_GRID * LATTICE_GRID * LATTICE_GRID];
+};
+
+// furthest a tree reaches from its trunk, must stay below CHUNK_SIZE
+#define TREE_RADIUS 2
+
+// one column of chunks, index x + z * CHUNK_SIZE. read only once ready
+struct column_t {
+  short heights[CHUNK_SIZE_SQUARED]; // 2d heightmap the density is centered on
+  short surface[CHUNK_SIZE_SQUARED]; // highest solid block after the density
+
+  bool ready;
+  uint users; // queued or running stage jobs reading it
+  std::vector<vec3i> waiting; // chunks to reschedule once it is ready
+};
+
+struct proto_chunk_t {
+  vec3i pos;
+  block_t* blocks;
+  uint64_t occupancy;
+  uint8_t stage; // next stage to run
+  bool queued; // a job for its next stage is queued or running
+  bool cancelled; // pruned while running, dropped when the job completes
+};
+
+// builds column when chunk is nullptr, otherwise runs the chunk's next stage
+struct job_t {
+  proto_chunk_t* chunk;
+  column_t* column;
+  vec3i pos;
+  column_t* columns[9]; // 3x3 around the chunk, [4] is its own column
+};
+
+namespace Terrain {
+uint seed = 0;
+
+// the seed moves the sample window around the noise fields
+float offsetX = 0.0f;
+float offsetZ = 0.0f;
+
+SlabPool* pool;
+std::vector<std::thread> workers;
+bool running = false;
+
+// everything below is guarded by the mutex, the data in columns and chunks is
+// only touched by the job that owns it or read after its stage completed
+std::mutex mutex;
+std::condition_variable condition;
+std::deque<job_t> jobs;
+std::map<vec3i, proto_chunk_t*> chunks;
+std::map<vec3i, column_t*> columns;
+std::vector<generated_chunk_t> finished;
+
+// lattice samples are shared between neighboring chunks, computed once by whichever needs them first
+std::mutex latticeMutex;
+std::map<vec3i, std::shared_ptr<const lattice_t>> lattices;
+}
+
+// splitmix32 style finalizer, spreads consecutive inputs far apart
+inline uint hashSeed(uint value) {
+  value ^= value >> 16;
+  value *= 0x7feb352d;
+  value ^= value >> 15;
+  value *= 0x846ca68b;
+  value ^= value >> 16;
+  return value;
+}
+
+inline uint hashColumn(int x, int z) {
+  return hashSeed((uint)x * 0x8da6b343 ^ (uint)z * 0xd8163841 ^ Terrain::seed);
+}
+
+inline float lerp(float a, float b, float t) {
+  return a * (1.0f - t) + b * t;
+}
+
+inline bool outside(vec3i pos, vec3i center, int distance) {
+  return abs(pos.x - center.x) > distance || abs(pos.y - center.y) > distance || abs(pos.z - center.z) > distance;
+}
+
+void Terrain::setSeed(uint _seed) {
+  seed = _seed;
+
+  if(seed == 0) {
+    offsetX = offsetZ = 0.0f;
+    return;
+  }
+
+  // stay within +-100000 blocks so the noise input keeps its precision
+  offsetX = (float)(hashSeed(seed) % 200001) - 100000.0f;
+  offsetZ = (float)(hashSeed(seed ^ 0x9e3779b9) % 200001) - 100000.0f;
+}
+
+uint Terrain::getSeed() {
+  return seed;
+}
+
+float getHeight(int x, int z, int xCS, int zCS, int octaves, float roughness, float smoothness, float amplitude) {
+  float xCoord = (float)(x + xCS) + Terrain::offsetX;
+  float zCoord = (float)(z + zCS) + Terrain::offsetZ;
+  float totalValue = 0.0f;
+
+  float frequency, _amplitude;
+
+  for(int octave = 0; octave < octaves - 1; octave++) {
+    frequency = glm::pow(2.0f, octave);
+    _amplitude = glm::pow(roughness, octave);
+    totalValue += glm::simplex(glm::vec2{xCoord* frequency / smoothness, zCoord* frequency / smoothness}) * _amplitude;
+  }
+
+  return ((totalValue / 2.1f) + 1.2f) * amplitude;
+}
+
+float sampleField(uint field, int x, int y, int z) {
+  glm::vec3 position = glm::vec3(x + Terrain::offsetX, y, z + Terrain::offsetZ);
+
+  if(field == OVERHANG_FIELD) {
+    return glm::simplex(position / 48.0f) * 0.7f + glm::simplex(position / 20.0f) * 0.3f;
+  }
+
+  return glm::simplex(position / 24.0f);
+}
+
+static std::shared_ptr<const lattice_t> getLattice(vec3i pos) {
+  using namespace Terrain;
+
+  {
+    std::lock_guard<std::mutex> lock(latticeMutex);
+    std::map<vec3i, std::shared_ptr<const lattice_t>>::iterator it = lattices.find(pos);
+
+    if(it != lattices.end()) {
+      return it->second;
+    }
+  }
+
+  PROFILE_SCOPE("terrain lattice")
+
+  // sampled without the lock, if another worker wins the race its identical copy is used
+  std::shared_ptr<lattice_t> lattice = std::make_shared<lattice_t>();
+
+  for(uint field = 0; field < FIELD_COUNT; field++) {
+    float* samples = lattice->samples[field];
+
+    for(int z = 0; z < LATTICE_SIZE; z++) {
+      for(int y = 0; y < LATTICE_SIZE; y++) {
+        for(int x = 0; x < LATTICE_SIZE; x++) {
+          samples[x + (y + z * LATTICE_SIZE) * LATTICE_SIZE] = sampleField(field, pos.x * CHUNK_SIZE + x * LATTICE_STEP, pos.y * CHUNK_SIZE + y * LATTICE_STEP, pos.z * CHUNK_SIZE + z * LATTICE_STEP);
+        }
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(latticeMutex);
+  return lattices.insert(std::make_pair(pos, std::shared_ptr<const lattice_t>(lattice))).first->second;
+}
+
+// gathers the samples of a chunk and its +x, +y and +z neighbors into one grid
+void gatherLattice(vec3i pos, uint field, lattice_grid_t* grid) {
+  std::shared_ptr<const lattice_t> neighbors[8];
+
+  for(int i = 0; i < 8; i++) {
+    neighbors[i] = getLattice({pos.x + (i & 1), pos.y + ((i >> 1) & 1), pos.z + ((i >> 2) & 1)});
+  }
+
+  for(int z = 0; z < LATTICE_GRID; z++) {
+    for(int y = 0; y < LATTICE_GRID; y++) {
+      for(int x = 0; x < LATTICE_GRID; x++) {
+        const lattice_t* lattice = neighbors[(x / LATTICE_SIZE) | ((y / LATTICE_SIZE) << 1) | ((z / LATTICE_SIZE) << 2)].get();
+        uint index = x % LATTICE_SIZE + (y % LATTICE_SIZE + z % LATTICE_SIZE * LATTICE_SIZE) * LATTICE_SIZE;
+
+        grid->samples[x + (y + z * LATTICE_GRID) * LATTICE_GRID] = lattice->samples[field][index];
+      }
+    }
+  }
+}
+
+// trilinear interpolation between the 8 lattice points around a block
+inline float interpolate(const lattice_grid_t* grid, uint8_t x, uint8_t y, uint8_t z) {
+  const uint gx = x / LATTICE_STEP, gy = y / LATTICE_STEP, gz = z / LATTICE_STEP;
+  const float fx = (x % LATTICE_STEP) / (float)LATTICE_STEP;
+  const float fy = (y % LATTICE_STEP) / (float)LATTICE_STEP;
+  const float fz = (z % LATTICE_STEP) / (float)LATTICE_STEP;
+
+  const float* s = grid->samples + gx + (gy + gz * LATTICE_GRID) * LATTICE_GRID;
+  const uint dy = LATTICE_GRID, dz = LATTICE_GRID * LATTICE_GRID;
+
+  float x00 = lerp(s[0], s[1], fx);
+  float x10 = lerp(s[dy], s[dy + 1], fx);
+  float x01 = lerp(s[dz], s[dz + 1], fx);
+  float x11 = lerp(s[dy + dz], s[dy + dz + 1], fx);
+
+  return lerp(lerp(x00, x10, fy), lerp(x01, x11, fy), fz);
+}
+
+// land fades the overhang noise in, so shores and the sea floor stay flat
+inline float overhangAmplitude(int height) {
+  return OVERHANG_AMPLITUDE * glm::clamp((height - (WATER_LEVEL + 4)) / 8.0f, 0.0f, 1.0f);
+}
+
+// positive where the block at height y of a column with the given 2d height is solid
+inline float getDensity(int height, int y, float noise) {
+  return (float)(height - y) + overhangAmplitude(height) * noise;
+}
+
+void buildColumn(column_t* column, int x, int z) {
+  PROFILE_SCOPE("terrain column")
+
+  int minHeight = INT32_MAX;
+  int maxHeight = INT32_MIN;
+
+  for(uint8_t dz = 0; dz < CHUNK_SIZE; dz++) {
+    for(uint8_t dx = 0; dx < CHUNK_SIZE; dx++) {
+      int height = MAX((int)getHeight(dx, dz, x * CHUNK_SIZE, z * CHUNK_SIZE, 8, 0.4f, 400.0f, 100.0f), WATER_LEVEL);
+      column->heights[dx + dz * CHUNK_SIZE] = (short)height;
+      minHeight = MIN(minHeight, height);
+      maxHeight = MAX(maxHeight, height);
+    }
+  }
+
+  // the density can only differ from the heightmap within the overhang band
+  const int minChunk = toChunkCoord(minHeight - OVERHANG_AMPLITUDE);
+  const int maxChunk = toChunkCoord(maxHeight + OVERHANG_AMPLITUDE);
+  std::vector<lattice_grid_t> grids(maxChunk - minChunk + 1);
+
+  for(int cy = minChunk; cy <= maxChunk; cy++) {
+    gatherLattice({x, cy, z}, OVERHANG_FIELD, &grids[cy - minChunk]);
+  }
+
+  for(uint8_t dz = 0; dz < CHUNK_SIZE; dz++) {
+    for(uint8_t dx = 0; dx < CHUNK_SIZE; dx++) {
+      int height = column->heights[dx + dz * CHUNK_SIZE];
+      int y = height + OVERHANG_AMPLITUDE;
+
+      for(; y > height - OVERHANG_AMPLITUDE; y--) {
+        float noise = interpolate(&grids[toChunkCoord(y) - minChunk], dx, toLocalCoord(y), dz);
+
+        if(getDensity(height, y, noise) >= 0.0f) {
+          break;
+        }
+      }
+
+      column->surface[dx + dz * CHUNK_SIZE] = (short)y;
+    }
+  }
+}
+
+void generateDensity(proto_chunk_t* chunk, const column_t* column) {
+  PROFILE_SCOPE("terrain density")
+
+  const int yCS = chunk->pos.y * CHUNK_SIZE;
+  lattice_grid_t grid;
+  bool gathered = false;
+
+  for(uint8_t dz = 0; dz < CHUNK_SIZE; dz++) {
+    for(uint8_t dx = 0; dx < CHUNK_SIZE; dx++) {
+      int height = column->heights[dx + dz * CHUNK_SIZE];
+
+      for(uint8_t dy = 0; dy < CHUNK_SIZE; dy++) {
+        int y = dy + yCS;
+        block_t block = y <= height ? STONE : AIR;
+
+        // only the band around the heightmap needs the noise
+        if(abs(y - height) <= OVERHANG_AMPLITUDE) {
+          if(!gathered) {
+            gatherLattice(chunk->pos, OVERHANG_FIELD, &grid);
+            gathered = true;
+          }
+
+          block = getDensity(height, y, interpolate(&grid, dx, dy, dz)) >= 0.0f ? STONE : AIR;
+        }
+
+        chunk->blocks[blockIndex(dx, dy, dz)] = block;
+      }
+    }
+  }
+}
+
+void generateCaves(proto_chunk_t* chunk, const column_t* column) {
+  PROFILE_SCOPE("terrain carving")
+
+  const int yCS = chunk->pos.y * CHUNK_SIZE;
+  lattice_grid_t grid;
+  bool gathered = false;
+
+  for(uint8_t dz = 0; dz < CHUNK_SIZE; dz++) {
+    for(uint8_t dx = 0; dx < CHUNK_SIZE; dx++) {
+      int top = column->surface[dx + dz * CHUNK_SIZE] - CAVE_DEPTH;
+
+      for(uint8_t dy = 0; dy < CHUNK_SIZE && dy + yCS < top; dy++) {
+        if(!gathered) {
+          gatherLattice(chunk->pos, CAVE_FIELD, &grid);
+          gathered = true;
+        }
+
+        if(interpolate(&grid, dx, dy, dz) > 0.6f) {
+          chunk->blocks[blockIndex(dx, dy, dz)] = AIR;
+        }
+      }
+    }
+  }
+}
+
+void generateSurface(proto_chunk_t* chunk, const column_t* column) {
+  PROFILE_SCOPE("terrain surface")
+
+  const int yCS = chunk->pos.y * CHUNK_SIZE;
+
+  for(uint8_t dz = 0; dz < CHUNK_SIZE; dz++) {
+    for(uint8_t dx = 0; dx < CHUNK_SIZE; dx++) {
+      int height = column->surface[dx + dz * CHUNK_SIZE];
+
+      for(uint8_t dy = 0; dy < CHUNK_SIZE; dy++) {
+        block_t& block = chunk->blocks[blockIndex(dx, dy, dz)];
+        int thickness = height - (dy + yCS);
+
+        if(block != STONE) {
+          continue;
+        }
+
+        block = height <= WATER_LEVEL && thickness <= 1 ? WATER :
+                height <= WATER_LEVEL + 3 && thickness <= 4 ? SAND :
+                thickness == 0 ? GRASS :
+                thickness <= 3 ? DIRT :
+                STONE;
+      }
+    }
+  }
+}
+
+inline void placeBlock(proto_chunk_t* chunk, int x, int y, int z, block_t block, block_t replaceable) {
+  if(x < 0 || y < 0 || z < 0 || x >= CHUNK_SIZE || y >= CHUNK_SIZE || z >= CHUNK_SIZE) {
+    return;
+  }
+
+  block_t& current = chunk->blocks[blockIndex(x, y, z)];
+
+  if(current == AIR || current == replaceable) {
+    current = block;
+  }
+}
+
+/*
+  every tree that reaches into the chunk is placed, including ones rooted in
+  neighbor columns. leaves only fill air and trunks only replace air or
+  leaves, so the result doesn't depend on the order trees are placed in
+*/
+void generateFeatures(proto_chunk_t* chunk, column_t* const* columns) {
+  PROFILE_SCOPE("terrain features")
+
+  const int xCS = chunk->pos.x * CHUNK_SIZE;
+  const int yCS = chunk->pos.y * CHUNK_SIZE;
+  const int zCS = chunk->pos.z * CHUNK_SIZE;
+
+  for(int z = zCS - TREE_RADIUS; z < zCS + CHUNK_SIZE + TREE_RADIUS; z++) {
+    for(int x = xCS - TREE_RADIUS; x < xCS + CHUNK_SIZE + TREE_RADIUS; x++) {
+      uint hash = hashColumn(x, z);
+
+      // about one tree per 128 columns
+      if((hash & 127) != 0) {
+        continue;
+      }
+
+      const column_t* column = columns[(toChunkCoord(z) - chunk->pos.z + 1) * 3 + toChunkCoord(x) - chunk->pos.x + 1];
+      int ground = column->surface[toLocalCoord(x) + toLocalCoord(z) * CHUNK_SIZE];
+
+      // trees only grow on grass
+      if(ground <= WATER_LEVEL + 3) {
+        continue;
+      }
+
+      int height = 4 + (hash >> 8) % 3;
+      int top = ground + height;
+      int lx = x - xCS;
+      int lz = z - zCS;
+
+      if(top + 1 < yCS || ground + 1 >= yCS + CHUNK_SIZE) {
+        continue;
+      }
+
+      for(int y = top - 2; y <= top + 1; y++) {
+        int radius = y >= top ? 1 : TREE_RADIUS;
+
+        for(int dz = -radius; dz <= radius; dz++) {
+          for(int dx = -radius; dx <= radius; dx++) {
+            if(radius == TREE_RADIUS && abs(dx) == TREE_RADIUS && abs(dz) == TREE_RADIUS) {
+              continue;
+            }
+
+            placeBlock(chunk, lx + dx, y - yCS, lz + dz, LEAVES, AIR);
+          }
+        }
+      }
+
+      for(int y = ground + 1; y < top; y++) {
+        placeBlock(chunk, lx, y - yCS, lz, LOG, LEAVES);
+      }
+    }
+  }
+}
+
+void runJob(job_t& job) {
+  if(job.chunk == nullptr) {
+    buildColumn(job.column, job.pos.x, job.pos.z);
+    return;
+  }
+
+  proto_chunk_t* chunk = job.chunk;
+
+  switch(chunk->stage) {
+    case Terrain::DENSITY:
+      chunk->blocks = (block_t*)Terrain::pool->allocate();
+      generateDensity(chunk, job.columns[4]);
+      break;
+
+    case Terrain::CARVING:
+      generateCaves(chunk, job.columns[4]);
+      break;
+
+    case Terrain::SURFACE:
+      generateSurface(chunk, job.columns[4]);
+      break;
+
+    case Terrain::FEATURES:
+      generateFeatures(chunk, job.columns);
+      chunk->occupancy = computeOccupancy(chunk->blocks);
+      break;
+  }
+}
+
+// expects the mutex to be held
+static column_t* getColumn(vec3i pos) {
+  using namespace Terrain;
+
+  std::map<vec3i, column_t*>::iterator it = columns.find(pos);
+
+  if(it != columns.end()) {
+    return it->second;
+  }
+
+  column_t* column = new column_t();
+  column->ready = false;
+  column->users = 0;
+  columns.insert(std::make_pair(pos, column));
+
+  job_t job;
+  job.chunk = nullptr;
+  job.column = column;
+  job.pos = pos;
+  jobs.push_back(job);
+  condition.notify_one();
+
+  return column;
+}
+
+// queues the chunk's next stage once the columns it reads are ready, expects the mutex to be held
+static void schedule(proto_chunk_t* chunk) {
+  using namespace Terrain;
+
+  const int radius = chunk->stage == FEATURES ? 1 : 0;
+  bool ready = true;
+
+  job_t job;
+  job.chunk = chunk;
+  job.column = nullptr;
+  job.pos = chunk->pos;
+
+  for(int dz = -1; dz <= 1; dz++) {
+    for(int dx = -1; dx <= 1; dx++) {
+      column_t*& column = job.columns[(dz + 1) * 3 + dx + 1];
+
+      if(abs(dx) > radius || abs(dz) > radius) {
+        column = nullptr;
+        continue;
+      }
+
+      column = getColumn({chunk->pos.x + dx, 0, chunk->pos.z + dz});
+
+      if(!column->ready) {
+        column->waiting.push_back(chunk->pos);
+        ready = false;
+      }
+    }
+  }
+
+  if(!ready) {
+    return;
+  }
+
+  for(column_t* column : job.columns) {
+    if(column != nullptr) {
+      column->users++;
+    }
+  }
+
+  chunk->queued = true;
+  jobs.push_back(job);
+  condition.notify_one();
+}
+
+static void destroyChunk(proto_chunk_t* chunk) {
+  if(chunk->blocks != nullptr) {
+    Terrain::pool->release(chunk->blocks);
+  }
+
+  delete chunk;
+}
+
+// expects the mutex to be held
+static void completeJob(job_t& job) {
+  using namespace Terrain;
+
+  if(job.chunk == nullptr) {
+    job.column->ready = true;
+    std::vector<vec3i> waiting;
+    waiting.swap(job.column->waiting);
+
+    for(const vec3i& pos : waiting) {
+      std::map<vec3i, proto_chunk_t*>::iterator it = chunks.find(pos);
+
+      if(it != chunks.end() && !it->second->queued) {
+        schedule(it->second);
+      }
+    }
+
+    return;
+  }
+
+  proto_chunk_t* chunk = job.chunk;
+  chunk->queued = false;
+
+  for(column_t* column : job.columns) {
+    if(column != nullptr) {
+      column->users--;
+    }
+  }
+
+  if(chunk->cancelled) {
+    destroyChunk(chunk);
+    return;
+  }
+
+  chunk->stage++;
+
+  if(chunk->stage < STAGE_COUNT) {
+    schedule(chunk);
+    return;
+  }
+
+  finished.push_back({chunk->pos, chunk->blocks, chunk->occupancy});
+  chunks.erase(chunk->pos);
+  delete chunk;
+}
+
+static void worker() {
+  using namespace Terrain;
+
+  Profiler::setThreadName("terrain");
+  std::unique_lock<std::mutex> lock(mutex);
+
+  while(true) {
+    condition.wait(lock, []() {
+      return !running || !jobs.empty();
+    });
+
+    if(!running) {
+      return;
+    }
+
+    job_t job = jobs.front();
+    jobs.pop_front();
+
+    lock.unlock();
+    runJob(job);
+    lock.lock();
+
+    completeJob(job);
+  }
+}
+
+void Terrain::init(uint threadCount, SlabPool* _pool) {
+  pool = _pool;
+  running = true;
+
+  for(uint i = 0; i < MAX(threadCount, 1u); i++) {
+    workers.push_back(std::thread(worker));
+  }
+}
+
+void Terrain::free() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    running = false;
+  }
+
+  condition.notify_all();
+
+  for(std::thread& thread : workers) {
+    thread.join();
+  }
+
+  workers.clear();
+  jobs.clear();
+
+  for(std::pair<const vec3i, proto_chunk_t*>& it : chunks) {
+    destroyChunk(it.second);
+  }
+
+  for(std::pair<const vec3i, column_t*>& it : columns) {
+    delete it.second;
+  }
+
+  for(generated_chunk_t& chunk : finished) {
+    pool->release(chunk.blocks);
+  }
+
+  chunks.clear();
+  columns.clear();
+  finished.clear();
+  lattices.clear();
+}
+
+void Terrain::request(vec3i pos) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  if(chunks.count(pos) > 0) {
+    return;
+  }
+
+  for(const generated_chunk_t& chunk : finished) {
+    if(chunk.pos == pos) {
+      return;
+    }
+  }
+
+  proto_chunk_t* chunk = new proto_chunk_t();
+  chunk->pos = pos;
+  chunk->blocks = nullptr;
+  chunk->occupancy = 0;
+  chunk->stage = DENSITY;
+  chunk->queued = false;
+  chunk->cancelled = false;
+  chunks.insert(std::make_pair(pos, chunk));
+
+  schedule(chunk);
+}
+
+uint Terrain::collect(std::vector<generated_chunk_t>& out, uint max) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  uint count = MIN(max, (uint)finished.size());
+  out.insert(out.end(), finished.begin(), finished.begin() + count);
+  finished.erase(finished.begin(), finished.begin() + count);
+
+  return count;
+}
+
+inline bool outsideBox(vec3i pos, vec3i min, vec3i max, int margin) {
+  return pos.x < min.x - margin || pos.y < min.y - margin || pos.z < min.z - margin || pos.x > max.x + margin || pos.y > max.y + margin || pos.z > max.z + margin;
+}
+
+// columns only have x and z, they are outside if they are outside horizontally
+inline bool outsideAreas(vec3i pos, const std::vector<Terrain::area_t>& areas, int margin, bool column) {
+  for(const Terrain::area_t& area : areas) {
+    vec3i compared = column ? vec3i{pos.x, area.center.y, pos.z} : pos;
+
+    if(!outside(compared, area.center, area.distance + margin)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*
+  drops the columns and lattices that no chunk still wanted can read,
+  outsideWanted(pos, margin, column) tells if pos is further than margin
+  from all of them. expects the mutex to be held
+*/
+template<typename F>
+static void evictCaches(F outsideWanted) {
+  using namespace Terrain;
+
+  // columns one further out stay, the outermost chunks' features read them
+  for(std::map<vec3i, column_t*>::iterator it = columns.begin(); it != columns.end();) {
+    column_t* column = it->second;
+
+    if(!column->ready || column->users > 0 || !outsideWanted(it->first, 1, true)) {
+      it++;
+      continue;
+    }
+
+    delete column;
+    it = columns.erase(it);
+  }
+
+  // columns build the overhang band of chunk positions outside the range, keep a little more
+  std::lock_guard<std::mutex> latticeLock(latticeMutex);
+
+  for(std::map<vec3i, std::shared_ptr<const lattice_t>>::iterator it = lattices.begin(); it != lattices.end();) {
+    if(outsideWanted(it->first, 2, false)) {
+      it = lattices.erase(it);
+    } else {
+      it++;
+    }
+  }
+}
+
+void Terrain::prune(vec3i center, int distance) {
+  prune(std::vector<area_t> {{center, distance}});
+}
+
+void Terrain::prune(const std::vector<area_t>& areas) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  // drop queued stages that haven't started, running ones are dropped when they complete
+  for(std::deque<job_t>::iterator it = jobs.begin(); it != jobs.end();) {
+    if(it->chunk == nullptr || !outsideAreas(it->pos, areas, 0, false)) {
+      it++;
+      continue;
+    }
+
+    for(column_t* column : it->columns) {
+      if(column != nullptr) {
+        column->users--;
+      }
+    }
+
+    it->chunk->queued = false;
+    it = jobs.erase(it);
+  }
+
+  for(std::map<vec3i, proto_chunk_t*>::iterator it = chunks.begin(); it != chunks.end();) {
+    proto_chunk_t* chunk = it->second;
+
+    if(!outsideAreas(chunk->pos, areas, 0, false)) {
+      it++;
+      continue;
+    }
+
+    if(chunk->queued) {
+      chunk->cancelled = true;
+    } else {
+      destroyChunk(chunk);
+    }
+
+    it = chunks.erase(it);
+  }
+
+  evictCaches([&areas](vec3i pos, int margin, bool column) {
+    return outsideAreas(pos, areas, margin, column);
+  });
+}
+
+void Terrain::trim(vec3i min, vec3i max) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  evictCaches([min, max](vec3i pos, int margin, bool column) {
+    if(column) {
+      pos.y = min.y;
+    }
+
+    return outsideBox(pos, min, max, margin);
+  });
+}
+
+uint Terrain::getPendingCount() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return (uint)chunks.size();
+}
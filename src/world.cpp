@@ -0,0 +1,401 @@
+#include "world.h"
+
+#include <set>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <functional>
+
+#include "chunk.h"
+#include "chunk_manager.h"
+#include "lighting.h"
+#include "fluids.h"
+#include "block_ticks.h"
+#include "profiler.h"
+
+// the part of one chunk a bulk edit touches, bounds in local block coordinates, inclusive
+struct edit_job_t {
+  std::shared_ptr<Chunk> chunk;
+  vec3i min;
+  vec3i max;
+  bool changed; // set by the edit, chunks it left as they were aren't remeshed or relit
+};
+
+// returns true if it changed any block
+typedef std::function<bool(Chunk* chunk, const edit_job_t& job)> edit_fn;
+
+namespace World {
+// last chunk used by get/set
+vec3i cachedPos;
+std::shared_ptr<Chunk> cachedChunk;
+}
+
+void World::free() {
+  cachedChunk.reset();
+}
+
+inline Chunk* getCachedChunk(int x, int y, int z) {
+  using namespace World;
+
+  vec3i pos = {toChunkCoord(x), toChunkCoord(y), toChunkCoord(z)};
+
+  // the cache holds the only other reference once the manager has unloaded the chunk
+  if(cachedChunk == nullptr || cachedPos != pos || cachedChunk.use_count() == 1) {
+    cachedPos = pos;
+    cachedChunk = ChunkManager::get(pos);
+  }
+
+  return cachedChunk.get();
+}
+
+// chunks share the faces on their borders, so edits on a border remesh the neighbor too
+static void markNeighbors(const std::vector<edit_job_t>& jobs) {
+  std::set<vec3i> edited;
+  std::set<vec3i> neighbors;
+
+  for(const edit_job_t& job : jobs) {
+    edited.insert({job.chunk->x, job.chunk->y, job.chunk->z});
+  }
+
+  for(const edit_job_t& job : jobs) {
+    const Chunk* chunk = job.chunk.get();
+
+    if(job.min.x == 0) {
+      neighbors.insert({chunk->x - 1, chunk->y, chunk->z});
+    }
+
+    if(job.max.x == CHUNK_SIZE - 1) {
+      neighbors.insert({chunk->x + 1, chunk->y, chunk->z});
+    }
+
+    if(job.min.y == 0) {
+      neighbors.insert({chunk->x, chunk->y - 1, chunk->z});
+    }
+
+    if(job.max.y == CHUNK_SIZE - 1) {
+      neighbors.insert({chunk->x, chunk->y + 1, chunk->z});
+    }
+
+    if(job.min.z == 0) {
+      neighbors.insert({chunk->x, chunk->y, chunk->z - 1});
+    }
+
+    if(job.max.z == CHUNK_SIZE - 1) {
+      neighbors.insert({chunk->x, chunk->y, chunk->z + 1});
+    }
+  }
+
+  for(const vec3i& pos : neighbors) {
+    if(edited.count(pos) > 0) {
+      continue;
+    }
+
+    std::shared_ptr<Chunk> chunk = ChunkManager::get(pos);
+
+    if(chunk != nullptr && !chunk->empty) {
+      chunk->changed = true;
+    }
+  }
+}
+
+// calls fn for every block within one block of the box's faces, on either side of them
+template<typename F>
+static void forEachNearFaces(vec3i min, vec3i max, F fn) {
+  for(int z = min.z - 1; z <= max.z + 1; z++) {
+    for(int y = min.y - 1; y <= max.y + 1; y++) {
+      // rows through the inside of the box only touch it at both ends
+      bool inner = z > min.z && z < max.z && y > min.y && y < max.y;
+
+      for(int x = min.x - 1; x <= max.x + 1; x += inner && x == min.x ? MAX(max.x - min.x, 1) : 1) {
+        fn(x, y, z);
+      }
+    }
+  }
+}
+
+// splits the box into one job per loaded chunk and runs fn on every job across the cores
+static void forEachChunk(vec3i min, vec3i max, bool write, const edit_fn& fn) {
+  std::vector<edit_job_t> jobs;
+
+  for(int cz = toChunkCoord(min.z); cz <= toChunkCoord(max.z); cz++) {
+    for(int cy = toChunkCoord(min.y); cy <= toChunkCoord(max.y); cy++) {
+      for(int cx = toChunkCoord(min.x); cx <= toChunkCoord(max.x); cx++) {
+        std::shared_ptr<Chunk> chunk = ChunkManager::get({cx, cy, cz});
+
+        if(chunk == nullptr) {
+          continue;
+        }
+
+        edit_job_t job;
+        job.chunk = chunk;
+        job.min = {MAX(min.x - cx * CHUNK_SIZE, 0), MAX(min.y - cy * CHUNK_SIZE, 0), MAX(min.z - cz * CHUNK_SIZE, 0)};
+        job.max = {MIN(max.x - cx * CHUNK_SIZE, CHUNK_SIZE - 1), MIN(max.y - cy * CHUNK_SIZE, CHUNK_SIZE - 1), MIN(max.z - cz * CHUNK_SIZE, CHUNK_SIZE - 1)};
+        job.changed = false;
+        jobs.push_back(job);
+      }
+    }
+  }
+
+  // every job owns a different chunk, so they need no locking between them. writes keep the lighting worker out
+  std::unique_lock<std::mutex> lightLock(Lighting::mutex, std::defer_lock);
+
+  if(write) {
+    lightLock.lock();
+  }
+
+  std::atomic<uint> next(0);
+  auto worker = [&]() {
+    uint i;
+
+    while((i = next.fetch_add(1)) < jobs.size()) {
+      Chunk* chunk = jobs[i].chunk.get();
+      jobs[i].changed = fn(chunk, jobs[i]);
+
+      if(write && jobs[i].changed) {
+        chunk->blocksChanged();
+      }
+    }
+  };
+
+  uint threadCount = MIN((uint)jobs.size(), MAX(std::thread::hardware_concurrency(), 1u));
+  std::vector<std::thread> threads;
+
+  for(uint i = 1; i < threadCount; i++) {
+    threads.push_back(std::thread(worker));
+  }
+
+  worker();
+
+  for(std::thread& thread : threads) {
+    thread.join();
+  }
+
+  if(write) {
+    lightLock.unlock();
+
+    jobs.erase(std::remove_if(jobs.begin(), jobs.end(), [](const edit_job_t & job) {
+      return !job.changed;
+    }), jobs.end());
+
+    markNeighbors(jobs);
+
+    for(const edit_job_t& job : jobs) {
+      const Chunk* chunk = job.chunk.get();
+
+      Lighting::chunkChanged({chunk->x, chunk->y, chunk->z});
+      BlockTicks::chunkChanged({chunk->x, chunk->y, chunk->z});
+
+      vec3i editMin = {chunk->x * CHUNK_SIZE + job.min.x, chunk->y * CHUNK_SIZE + job.min.y, chunk->z * CHUNK_SIZE + job.min.z};
+      vec3i editMax = {chunk->x * CHUNK_SIZE + job.max.x, chunk->y * CHUNK_SIZE + job.max.y, chunk->z * CHUNK_SIZE + job.max.z};
+
+      // water and sand can only start moving where the edit meets other blocks, activate also wakes the cells next to it
+      forEachNearFaces(editMin, editMax, [](int x, int y, int z) {
+        if(isWater(World::get(x, y, z))) {
+          Fluids::activate(x, y, z);
+        }
+
+        BlockTicks::neighborChanged(x, y, z);
+      });
+    }
+  }
+}
+
+block_t World::get(int x, int y, int z) {
+  Chunk* chunk = getCachedChunk(x, y, z);
+
+  if(chunk == nullptr) {
+    return AIR;
+  }
+
+  return chunk->get(toLocalCoord(x), toLocalCoord(y), toLocalCoord(z));
+}
+
+bool World::set(int x, int y, int z, block_t block) {
+  if(getCachedChunk(x, y, z) == nullptr) {
+    return false;
+  }
+
+  setBlocks({{x, y, z, block}});
+
+  return true;
+}
+
+void World::setBlocks(const std::vector<block_edit_t>& edits) {
+  std::vector<edit_job_t> jobs;
+  jobs.reserve(edits.size());
+
+  // one lock for the whole batch, Chunk::set only flags the chunk for remeshing
+  {
+    std::lock_guard<std::mutex> lock(Lighting::mutex);
+
+    for(const block_edit_t& edit : edits) {
+      Chunk* chunk = getCachedChunk(edit.x, edit.y, edit.z);
+
+      if(chunk == nullptr) {
+        continue;
+      }
+
+      edit_job_t job;
+      job.chunk = cachedChunk;
+      job.min = job.max = {toLocalCoord(edit.x), toLocalCoord(edit.y), toLocalCoord(edit.z)};
+      job.changed = true;
+
+      chunk->set((uint8_t)job.min.x, (uint8_t)job.min.y, (uint8_t)job.min.z, edit.block);
+      jobs.push_back(job);
+    }
+  }
+
+  markNeighbors(jobs);
+
+  for(const edit_job_t& job : jobs) {
+    int x = job.chunk->x * CHUNK_SIZE + job.min.x;
+    int y = job.chunk->y * CHUNK_SIZE + job.min.y;
+    int z = job.chunk->z * CHUNK_SIZE + job.min.z;
+
+    Lighting::blockChanged(x, y, z);
+    Fluids::activate(x, y, z);
+    BlockTicks::blockChanged(x, y, z);
+  }
+}
+
+void World::fillBox(vec3i min, vec3i max, block_t block) {
+  PROFILE_SCOPE("world fill box")
+
+  forEachChunk(min, max, true, [block](Chunk * chunk, const edit_job_t& job) {
+    block_t* blocks = chunk->getBlocks();
+    bool changed = false;
+
+    for(int z = job.min.z; z <= job.max.z; z++) {
+      for(int y = job.min.y; y <= job.max.y; y++) {
+        for(int x = job.min.x; x <= job.max.x; x++) {
+          block_t& current = blocks[blockIndex(x, y, z)];
+          changed |= current != block;
+          current = block;
+        }
+      }
+    }
+
+    return changed;
+  });
+}
+
+void World::fillSphere(glm::vec3 center, float radius, block_t block) {
+  PROFILE_SCOPE("world fill sphere")
+
+  vec3i min = {(int)floorf(center.x - radius), (int)floorf(center.y - radius), (int)floorf(center.z - radius)};
+  vec3i max = {(int)floorf(center.x + radius), (int)floorf(center.y + radius), (int)floorf(center.z + radius)};
+  float radiusSquared = radius * radius;
+
+  forEachChunk(min, max, true, [center, radiusSquared, block](Chunk * chunk, const edit_job_t& job) {
+    block_t* blocks = chunk->getBlocks();
+    bool changed = false;
+    glm::vec3 origin = glm::vec3(chunk->x, chunk->y, chunk->z) * (float)CHUNK_SIZE + 0.5f - center;
+
+    for(int z = job.min.z; z <= job.max.z; z++) {
+      for(int y = job.min.y; y <= job.max.y; y++) {
+        for(int x = job.min.x; x <= job.max.x; x++) {
+          glm::vec3 offset = origin + glm::vec3(x, y, z);
+
+          if(glm::dot(offset, offset) <= radiusSquared) {
+            block_t& current = blocks[blockIndex(x, y, z)];
+            changed |= current != block;
+            current = block;
+          }
+        }
+      }
+    }
+
+    return changed;
+  });
+}
+
+void World::replace(vec3i min, vec3i max, block_t from, block_t to) {
+  PROFILE_SCOPE("world replace")
+
+  forEachChunk(min, max, true, [from, to](Chunk * chunk, const edit_job_t& job) {
+    block_t* blocks = chunk->getBlocks();
+    bool changed = false;
+
+    for(int z = job.min.z; z <= job.max.z; z++) {
+      for(int y = job.min.y; y <= job.max.y; y++) {
+        for(int x = job.min.x; x <= job.max.x; x++) {
+          block_t& block = blocks[blockIndex(x, y, z)];
+
+          if(block == from && from != to) {
+            block = to;
+            changed = true;
+          }
+        }
+      }
+    }
+
+    return changed;
+  });
+}
+
+World::region_t World::copy(vec3i min, vec3i max) {
+  PROFILE_SCOPE("world copy")
+
+  region_t region;
+  region.size = {max.x - min.x + 1, max.y - min.y + 1, max.z - min.z + 1};
+  region.blocks.assign((size_t)region.size.x * region.size.y * region.size.z, AIR);
+
+  block_t* out = region.blocks.data();
+  const vec3i size = region.size;
+
+  forEachChunk(min, max, false, [out, size, min](Chunk * chunk, const edit_job_t& job) {
+    const block_t* blocks = chunk->getBlocks();
+    vec3i base = {chunk->x * CHUNK_SIZE - min.x, chunk->y * CHUNK_SIZE - min.y, chunk->z * CHUNK_SIZE - min.z};
+
+    for(int z = job.min.z; z <= job.max.z; z++) {
+      for(int y = job.min.y; y <= job.max.y; y++) {
+        size_t row = ((size_t)(base.z + z) * size.y + (base.y + y)) * size.x + base.x;
+
+        for(int x = job.min.x; x <= job.max.x; x++) {
+          out[row + x] = blocks[blockIndex(x, y, z)];
+        }
+      }
+    }
+
+    return false;
+  });
+
+  return region;
+}
+
+void World::paste(const region_t& region, vec3i origin, bool pasteAir) {
+  PROFILE_SCOPE("world paste")
+
+  if(region.blocks.empty()) {
+    return;
+  }
+
+  vec3i max = {origin.x + region.size.x - 1, origin.y + region.size.y - 1, origin.z + region.size.z - 1};
+  const block_t* in = region.blocks.data();
+  const vec3i size = region.size;
+
+  forEachChunk(origin, max, true, [in, size, origin, pasteAir](Chunk * chunk, const edit_job_t& job) {
+    block_t* blocks = chunk->getBlocks();
+    bool changed = false;
+    vec3i base = {chunk->x * CHUNK_SIZE - origin.x, chunk->y * CHUNK_SIZE - origin.y, chunk->z * CHUNK_SIZE - origin.z};
+
+    for(int z = job.min.z; z <= job.max.z; z++) {
+      for(int y = job.min.y; y <= job.max.y; y++) {
+        size_t row = ((size_t)(base.z + z) * size.y + (base.y + y)) * size.x + base.x;
+
+        for(int x = job.min.x; x <= job.max.x; x++) {
+          block_t block = in[row + x];
+
+          if(pasteAir || block != AIR) {
+            block_t& current = blocks[blockIndex(x, y, z)];
+            changed |= current != block;
+            current = block;
+          }
+        }
+      }
+    }
+
+    return changed;
+  });
+}
@@ -0,0 +1,318 @@
+#include "world_storage.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <mutex>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#else
+#include <dirent.h>
+#endif
+
+const static char WORLD_MAGIC[4] = {'C', 'V', 'X', 'W'};
+const static char REGION_MAGIC[4] = {'C', 'V', 'X', 'R'};
+const static size_t REGION_HEADER_SIZE = 8 + WorldStorage::REGION_CHUNKS * 8;
+
+// regions kept in memory, the least recently used one is dropped past this
+const static size_t MAX_CACHED_REGIONS = 64;
+
+// a whole region file, empty when the region isn't on disk. loaders keep their own reference, so eviction never frees data in use
+struct cached_region_t {
+  std::shared_ptr<const std::vector<uint8_t>> data;
+  uint64_t lastUsed;
+};
+
+namespace WorldStorage {
+std::string path;
+bool opened = false;
+
+std::mutex regionsMutex;
+std::map<vec3i, cached_region_t> regions;
+uint64_t regionUses = 0;
+}
+
+inline void putU32(std::vector<uint8_t>& out, uint value) {
+  out.push_back(value & 0xff);
+  out.push_back((value >> 8) & 0xff);
+  out.push_back((value >> 16) & 0xff);
+  out.push_back((value >> 24) & 0xff);
+}
+
+inline uint getU32(const uint8_t* in) {
+  return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint)in[3] << 24);
+}
+
+// drops the least recently used region, regionsMutex must be held
+static void evictRegion() {
+  using namespace WorldStorage;
+
+  std::map<vec3i, cached_region_t>::iterator oldest = regions.begin();
+
+  for(std::map<vec3i, cached_region_t>::iterator it = regions.begin(); it != regions.end(); it++) {
+    if(it->second.lastUsed < oldest->second.lastUsed) {
+      oldest = it;
+    }
+  }
+
+  regions.erase(oldest);
+}
+
+static std::string getRegionPath(const std::string& directory, vec3i region) {
+  char name[64];
+  snprintf(name, sizeof(name), "/r.%d.%d.%d.bin", region.x, region.y, region.z);
+  return directory + name;
+}
+
+static bool readFile(const std::string& filePath, std::vector<uint8_t>& out) {
+  FILE* file = fopen(filePath.c_str(), "rb");
+
+  if(file == NULL) {
+    return false;
+  }
+
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  out.resize(size > 0 ? size : 0);
+  bool ok = size > 0 && fread(out.data(), 1, out.size(), file) == out.size();
+  fclose(file);
+
+  return ok;
+}
+
+static bool writeFile(const std::string& filePath, const std::vector<uint8_t>& data) {
+  FILE* file = fopen(filePath.c_str(), "wb");
+
+  if(file == NULL) {
+    fprintf(stderr, "%s: unable to write %s\n", __func__, filePath.c_str());
+    return false;
+  }
+
+  bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+  fclose(file);
+
+  return ok;
+}
+
+static bool isRegionFile(const char* name) {
+  size_t length = strlen(name);
+  return length > 6 && strncmp(name, "r.", 2) == 0 && strcmp(name + length - 4, ".bin") == 0;
+}
+
+// deletes every r.*.bin in directory, so a recreated world doesn't load regions of the old one
+static bool removeRegionFiles(const std::string& directory) {
+  bool ok = true;
+
+#ifdef _WIN32
+  _finddata_t entry;
+  intptr_t handle = _findfirst((directory + "/r.*.bin").c_str(), &entry);
+
+  if(handle == -1) {
+    return true;
+  }
+
+  do {
+    if(isRegionFile(entry.name) && remove((directory + "/" + entry.name).c_str()) != 0) {
+      ok = false;
+    }
+  } while(_findnext(handle, &entry) == 0);
+
+  _findclose(handle);
+#else
+  DIR* dir = opendir(directory.c_str());
+
+  if(dir == NULL) {
+    return true;
+  }
+
+  while(dirent* entry = readdir(dir)) {
+    if(isRegionFile(entry->d_name) && remove((directory + "/" + entry->d_name).c_str()) != 0) {
+      ok = false;
+    }
+  }
+
+  closedir(dir);
+#endif
+
+  if(!ok) {
+    fprintf(stderr, "%s: unable to delete the old regions in %s\n", __func__, directory.c_str());
+  }
+
+  return ok;
+}
+
+void WorldStorage::encodeChunk(const block_t* blocks, std::vector<uint8_t>& out) {
+  uint i = 0;
+
+  while(i < CHUNK_SIZE_CUBED) {
+    block_t block = blocks[i];
+    uint count = 1;
+
+    while(i + count < CHUNK_SIZE_CUBED && blocks[i + count] == block && count < 0xffff) {
+      count++;
+    }
+
+    out.push_back(block);
+    out.push_back(count & 0xff);
+    out.push_back(count >> 8);
+    i += count;
+  }
+}
+
+bool WorldStorage::decodeChunk(const uint8_t* in, size_t size, block_t* blocks) {
+  uint i = 0;
+
+  for(size_t j = 0; j + 3 <= size; j += 3) {
+    uint count = in[j + 1] | (in[j + 2] << 8);
+
+    // ids come from disk or the network, one the block tables don't know would be read out of bounds
+    if(i + count > CHUNK_SIZE_CUBED || !isValidBlock(in[j])) {
+      return false;
+    }
+
+    memset(blocks + i, in[j], count);
+    i += count;
+  }
+
+  return i == CHUNK_SIZE_CUBED;
+}
+
+bool WorldStorage::open(const char* directory, uint* seed) {
+  std::vector<uint8_t> data;
+
+  if(!readFile(std::string(directory) + "/world.dat", data)) {
+    return false;
+  }
+
+  if(data.size() < 12 || memcmp(data.data(), WORLD_MAGIC, 4) != 0 || getU32(&data[4]) != VERSION) {
+    fprintf(stderr, "%s: %s is not a version %u world\n", __func__, directory, VERSION);
+    return false;
+  }
+
+  *seed = getU32(&data[8]);
+  path = directory;
+  opened = true;
+
+  return true;
+}
+
+bool WorldStorage::create(const char* directory, uint seed, bool overwrite) {
+  struct stat info;
+  std::string worldPath = std::string(directory) + "/world.dat";
+
+  if(stat(worldPath.c_str(), &info) == 0) {
+    if(!overwrite) {
+      fprintf(stderr, "%s: %s already holds a world\n", __func__, directory);
+      return false;
+    }
+
+    if(!removeRegionFiles(directory)) {
+      return false;
+    }
+  }
+
+#ifdef _WIN32
+  _mkdir(directory);
+#else
+  mkdir(directory, 0755);
+#endif
+
+  std::vector<uint8_t> data(WORLD_MAGIC, WORLD_MAGIC + 4);
+  putU32(data, VERSION);
+  putU32(data, seed);
+
+  return writeFile(worldPath, data);
+}
+
+void WorldStorage::close() {
+  std::lock_guard<std::mutex> lock(regionsMutex);
+
+  regions.clear();
+  regionUses = 0;
+  opened = false;
+}
+
+bool WorldStorage::isOpen() {
+  return opened;
+}
+
+bool WorldStorage::loadChunk(int x, int y, int z, block_t* blocks) {
+  if(!opened) {
+    return false;
+  }
+
+  vec3i region = {toRegionCoord(x), toRegionCoord(y), toRegionCoord(z)};
+  std::shared_ptr<const std::vector<uint8_t>> data;
+
+  {
+    std::lock_guard<std::mutex> lock(regionsMutex);
+    std::map<vec3i, cached_region_t>::iterator it = regions.find(region);
+
+    if(it == regions.end()) {
+      std::shared_ptr<std::vector<uint8_t>> file = std::make_shared<std::vector<uint8_t>>();
+
+      if(!readFile(getRegionPath(path, region), *file) || file->size() < REGION_HEADER_SIZE || memcmp(file->data(), REGION_MAGIC, 4) != 0) {
+        file->clear();
+      }
+
+      if(regions.size() >= MAX_CACHED_REGIONS) {
+        evictRegion();
+      }
+
+      it = regions.insert(std::make_pair(region, cached_region_t{file, 0})).first;
+    }
+
+    it->second.lastUsed = ++regionUses;
+    data = it->second.data;
+  }
+
+  if(data->empty()) {
+    return false;
+  }
+
+  uint index = (x - region.x * REGION_SIZE) + (y - region.y * REGION_SIZE) * REGION_SIZE + (z - region.z * REGION_SIZE) * REGION_SIZE * REGION_SIZE;
+  uint offset = getU32(data->data() + 8 + index * 8);
+  uint size = getU32(data->data() + 12 + index * 8);
+
+  if(size == 0) {
+    return false;
+  }
+
+  if((size_t)offset + size > data->size() || !decodeChunk(data->data() + offset, size, blocks)) {
+    fprintf(stderr, "%s: chunk %d %d %d is corrupt, regenerating it\n", __func__, x, y, z);
+    return false;
+  }
+
+  return true;
+}
+
+bool WorldStorage::writeRegion(const char* directory, vec3i region, const block_t* const* chunks) {
+  std::vector<uint8_t> data(REGION_MAGIC, REGION_MAGIC + 4);
+  putU32(data, VERSION);
+  data.resize(REGION_HEADER_SIZE, 0);
+
+  for(uint i = 0; i < REGION_CHUNKS; i++) {
+    if(chunks[i] == nullptr) {
+      continue;
+    }
+
+    uint offset = (uint)data.size();
+    encodeChunk(chunks[i], data);
+    uint size = (uint)data.size() - offset;
+
+    for(uint j = 0; j < 4; j++) {
+      data[8 + i * 8 + j] = (offset >> (j * 8)) & 0xff;
+      data[12 + i * 8 + j] = (size >> (j * 8)) & 0xff;
+    }
+  }
+
+  return writeFile(getRegionPath(directory, region), data);
+}
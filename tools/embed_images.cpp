@@ -1,51 +1,161 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
 #include <string>
-#include <algorithm>
+#include <vector>
+#include <fstream>
 
-void compileImagePNGtoBinary(const char* name, const char* filename, const char* output) {
-  FILE* file = fopen(filename, "rb");
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
 
-  if(file == NULL) {
-    fprintf(stderr, "error opening source file\n");
-    exit(0);
+/*
+  compiles the textures listed in res/list.txt into one texture array blob
+  for the asset pack. every layer is decoded and mipmapped here, the blob is
+  a {count, resolution, levels, reserved} uint32 header followed by all
+  levels from the largest down, each level with its layers in list order, so
+  the game uploads it without decoding anything
+*/
+
+typedef std::vector<uint8_t> image_t;
+
+float srgbToLinear(uint8_t value) {
+  float c = value / 255.0f;
+  return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+}
+
+uint8_t linearToSrgb(float value) {
+  float c = value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+  return (uint8_t)(fminf(fmaxf(c, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+// box filters a 2x2 footprint per texel, in linear space and weighted by alpha so transparent texels don't darken the edges
+image_t downsample(const image_t& source, int sourceRes) {
+  int res = sourceRes / 2;
+  image_t result(res * res * 4);
+
+  for(int y = 0; y < res; y++) {
+    for(int x = 0; x < res; x++) {
+      float color[3] = {0.0f, 0.0f, 0.0f};
+      float alpha = 0.0f;
+
+      for(int i = 0; i < 4; i++) {
+        const uint8_t* texel = &source[(((y * 2 + i / 2) * sourceRes) + x * 2 + i % 2) * 4];
+        float weight = texel[3] / 255.0f;
+
+        for(int c = 0; c < 3; c++) {
+          color[c] += srgbToLinear(texel[c]) * weight;
+        }
+
+        alpha += weight;
+      }
+
+      uint8_t* out = &result[(y * res + x) * 4];
+
+      for(int c = 0; c < 3; c++) {
+        out[c] = alpha > 0.0f ? linearToSrgb(color[c] / alpha) : 0;
+      }
+
+      out[3] = (uint8_t)(alpha / 4.0f * 255.0f + 0.5f);
+    }
   }
 
-  FILE* out = fopen(output, "w");
+  return result;
+}
+
+int main() {
+  std::ifstream listFile("res/list.txt");
 
-  if(out == NULL) {
-    fprintf(stderr, "error opening output file\n");
-    exit(0);
+  if(!listFile) {
+    fprintf(stderr, "error opening texture list file\n");
+    return -1;
   }
 
-  unsigned char buffer[32];
-  size_t count;
-  fprintf(out, "#ifndef IMAGE_%s\n#define IMAGE_%s\nstatic unsigned char IMAGE_%s_BYTES[] = {", name, name, name);
+  // flipped like the rest of the gl textures
+  stbi_set_flip_vertically_on_load(true);
+
+  std::vector<std::vector<image_t>> levels;
+  std::string name;
+  int res = 0;
+
+  while(std::getline(listFile, name, '\n')) {
+    if(name.empty()) {
+      continue;
+    }
+
+    printf("compiling texture: %s\n", name.c_str());
+
+    int width, height, channels;
+    std::string filename = std::string("res/") + name + std::string(".png");
+    uint8_t* data = stbi_load(filename.c_str(), &width, &height, &channels, STBI_rgb_alpha);
 
-  while(!feof(file)) {
-    count = fread(buffer, 1, 32, file);
+    if(data == NULL) {
+      fprintf(stderr, "error loading %s\n", filename.c_str());
+      return -1;
+    }
+
+    if(res == 0) {
+      res = width;
+    }
+
+    // a square power of two keeps the chain down to 1x1 exact
+    if(width != height || width != res || (res & (res - 1)) != 0) {
+      fprintf(stderr, "%s is %dx%d, every texture must be %dx%d and a power of two\n", filename.c_str(), width, height, res, res);
+      return -1;
+    }
+
+    image_t image(data, data + width * height * 4);
+    stbi_image_free(data);
 
-    for(size_t i = 0; i < count; i++) {
-      fprintf(out, "0x%02X,", buffer[i]);
+    for(int level = 0, levelRes = res; levelRes > 0; level++, levelRes /= 2) {
+      if((int)levels.size() <= level) {
+        levels.resize(level + 1);
+      }
+
+      if(level > 0) {
+        image = downsample(image, levelRes * 2);
+      }
+
+      levels[level].push_back(image);
     }
   }
 
-  fprintf(out, "};\n#endif");
-  fclose(file);
-  fclose(out);
-};
+  listFile.close();
 
-int main(int argc, char** argv) {
-  if(argc != 2) {
-    printf("you must provide a single filename\n");
-    return 0;
+  if(levels.empty()) {
+    fprintf(stderr, "no textures listed\n");
+    return -1;
   }
 
-  std::string name = argv[1];
-  std::string nameUpper = name;
-  transform(nameUpper.begin(), nameUpper.end(), nameUpper.begin(), ::toupper);
+  FILE* out = fopen("embed/textures.bin", "wb");
+
+  if(out == NULL) {
+    fprintf(stderr, "error opening output file\n");
+    return -1;
+  }
+
+  // little endian like the rest of the asset pack, whatever the host is
+  uint32_t header[4] = {(uint32_t)levels[0].size(), (uint32_t)res, (uint32_t)levels.size(), 0};
+  uint8_t headerBytes[sizeof(header)];
+
+  for(uint32_t i = 0; i < sizeof(headerBytes); i++) {
+    headerBytes[i] = (header[i / 4] >> ((i % 4) * 8)) & 0xff;
+  }
+
+  fwrite(headerBytes, sizeof(headerBytes), 1, out);
+
+  size_t count = 0;
+
+  for(const std::vector<image_t>& layers : levels) {
+    for(const image_t& layer : layers) {
+      fwrite(layer.data(), 1, layer.size(), out);
+      count += layer.size();
+    }
+  }
+
+  fclose(out);
 
-  printf("converting image to binary: %s\n", name.c_str());
-  compileImagePNGtoBinary(nameUpper.c_str(), (std::string("res/") + name + std::string(".png")).c_str(), (std::string("embed/res/") + name + std::string(".h")).c_str());
+  printf("%u textures, %u levels, %zu bytes\n", (unsigned)levels[0].size(), (unsigned)levels.size(), count);
 
   return 0;
 }
@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <string>
+#include <fstream>
+
+#include "asset_pack.h"
+
+// builds assets.pak from the shaders in shaders/list.txt and the texture blob written by embed_images
+
+bool readFile(const std::string& path, std::vector<uint8_t>& out) {
+  std::ifstream file(path, std::ios::binary);
+
+  if(!file) {
+    fprintf(stderr, "error opening %s\n", path.c_str());
+    return false;
+  }
+
+  out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+  return true;
+}
+
+bool addAsset(AssetPack::asset_list& assets, const std::string& name, const std::string& path) {
+  printf("packing asset: %s\n", name.c_str());
+
+  assets.push_back(std::make_pair(name, std::vector<uint8_t>()));
+
+  return readFile(path, assets.back().second);
+}
+
+int main(int argc, char** argv) {
+  const char* output = argc > 1 ? argv[1] : "assets.pak";
+
+  std::ifstream listFile("shaders/list.txt");
+
+  if(!listFile) {
+    fprintf(stderr, "error opening shader list file\n");
+    return -1;
+  }
+
+  AssetPack::asset_list assets;
+  std::string name;
+
+  while(std::getline(listFile, name, '\n')) {
+    if(name.empty()) {
+      continue;
+    }
+
+    // pack names match the paths under the override directory
+    for(const char* stage : {"vertex", "fragment"}) {
+      std::string path = std::string("shaders/") + name + "/" + stage + ".glsl";
+
+      if(!addAsset(assets, path, path)) {
+        return -1;
+      }
+    }
+  }
+
+  listFile.close();
+
+  if(!addAsset(assets, "textures", "embed/textures.bin")) {
+    return -1;
+  }
+
+  if(!AssetPack::write(output, assets)) {
+    return -1;
+  }
+
+  printf("wrote %u assets to %s\n", (unsigned)assets.size(), output);
+
+  return 0;
+}
@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <chrono>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include "common.h"
+#include "terrain.h"
+#include "world_storage.h"
+
+/*
+  generates every chunk within radius of a center chunk on the terrain
+  pipeline's workers and writes them as a world the game loads instead of
+  generating. output only depends on the seed, so reruns produce identical files
+*/
+
+// a region being generated, written once every chunk of it has arrived
+struct pending_region_t {
+  const block_t* chunks[WorldStorage::REGION_CHUNKS];
+  uint remaining;
+};
+
+struct pregen_t {
+  const char* directory;
+  vec3i center;
+  int radius;
+
+  std::vector<vec3i> regions;
+  std::map<vec3i, pending_region_t> pending;
+  uint nextRegion;
+  uint chunksGenerated;
+  uint regionsFailed;
+};
+
+inline bool insideRadius(const pregen_t& pregen, int x, int y, int z) {
+  return abs(x - pregen.center.x) <= pregen.radius && abs(y - pregen.center.y) <= pregen.radius && abs(z - pregen.center.z) <= pregen.radius;
+}
+
+// drops the terrain caches outside the chunks of the regions still in flight
+void trimTerrain(const pregen_t& pregen) {
+  using namespace WorldStorage;
+
+  if(pregen.pending.empty()) {
+    return;
+  }
+
+  vec3i min = {INT_MAX, INT_MAX, INT_MAX};
+  vec3i max = {INT_MIN, INT_MIN, INT_MIN};
+
+  for(const std::pair<const vec3i, pending_region_t>& it : pregen.pending) {
+    min = {MIN(min.x, it.first.x), MIN(min.y, it.first.y), MIN(min.z, it.first.z)};
+    max = {MAX(max.x, it.first.x), MAX(max.y, it.first.y), MAX(max.z, it.first.z)};
+  }
+
+  vec3i minChunk = {min.x * REGION_SIZE, min.y * REGION_SIZE, min.z * REGION_SIZE};
+  vec3i maxChunk = {(max.x + 1) * REGION_SIZE - 1, (max.y + 1) * REGION_SIZE - 1, (max.z + 1) * REGION_SIZE - 1};
+
+  Terrain::trim(minChunk, maxChunk);
+}
+
+// queues every chunk of the next region, returns false once all regions are queued
+bool queueRegion(pregen_t& pregen) {
+  using namespace WorldStorage;
+
+  if(pregen.nextRegion >= pregen.regions.size()) {
+    return false;
+  }
+
+  vec3i region = pregen.regions[pregen.nextRegion++];
+  pending_region_t& pending = pregen.pending[region];
+  pending.remaining = 0;
+
+  for(int z = 0; z < REGION_SIZE; z++) {
+    for(int y = 0; y < REGION_SIZE; y++) {
+      for(int x = 0; x < REGION_SIZE; x++) {
+        vec3i pos = {region.x * REGION_SIZE + x, region.y * REGION_SIZE + y, region.z * REGION_SIZE + z};
+        pending.chunks[x + y * REGION_SIZE + z * REGION_SIZE * REGION_SIZE] = nullptr;
+
+        if(insideRadius(pregen, pos.x, pos.y, pos.z)) {
+          Terrain::request(pos);
+          pending.remaining++;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+int main(int argc, char** argv) {
+  const char* program = argv[0];
+  bool force = argc > 1 && strcmp(argv[1], "--force") == 0;
+
+  // the remaining arguments keep their positions
+  if(force) {
+    argc--;
+    argv++;
+  }
+
+  if(argc != 4 && argc != 7) {
+    printf("usage: %s [--force] <directory> <seed> <radius> [chunk x] [chunk y] [chunk z]\n", program);
+    return -1;
+  }
+
+  pregen_t pregen;
+  pregen.directory = argv[1];
+  uint seed = (uint)strtoul(argv[2], NULL, 10);
+  pregen.radius = atoi(argv[3]);
+  pregen.center = {0, 0, 0};
+
+  if(argc == 7) {
+    pregen.center = {atoi(argv[4]), atoi(argv[5]), atoi(argv[6])};
+  }
+
+  if(pregen.radius < 0) {
+    fprintf(stderr, "%s: radius must not be negative\n", __func__);
+    return -1;
+  }
+
+  Terrain::setSeed(seed);
+
+  if(!WorldStorage::create(pregen.directory, seed, force)) {
+    return -1;
+  }
+
+  vec3i min = {
+    WorldStorage::toRegionCoord(pregen.center.x - pregen.radius),
+    WorldStorage::toRegionCoord(pregen.center.y - pregen.radius),
+    WorldStorage::toRegionCoord(pregen.center.z - pregen.radius)
+  };
+  vec3i max = {
+    WorldStorage::toRegionCoord(pregen.center.x + pregen.radius),
+    WorldStorage::toRegionCoord(pregen.center.y + pregen.radius),
+    WorldStorage::toRegionCoord(pregen.center.z + pregen.radius)
+  };
+
+  // whole stacks of regions in a row, so the columns they share are dropped once and never rebuilt
+  for(int z = min.z; z <= max.z; z++) {
+    for(int x = min.x; x <= max.x; x++) {
+      for(int y = min.y; y <= max.y; y++) {
+        pregen.regions.push_back({x, y, z});
+      }
+    }
+  }
+
+  pregen.nextRegion = 0;
+  pregen.chunksGenerated = 0;
+  pregen.regionsFailed = 0;
+
+  uint threadCount = MAX(std::thread::hardware_concurrency(), 1u);
+  printf("generating %d chunks around %d %d %d in %u regions, seed %u, %u threads\n", (pregen.radius * 2 + 1) * (pregen.radius * 2 + 1) * (pregen.radius * 2 + 1),
+         pregen.center.x, pregen.center.y, pregen.center.z, (uint)pregen.regions.size(), seed, threadCount);
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  SlabPool pool(CHUNK_SIZE_CUBED * sizeof(block_t), 64, MemoryTracker::CHUNK_STORAGE);
+  Terrain::init(threadCount, &pool);
+
+  // a few regions per worker in flight keeps every core busy without holding the whole world in memory
+  for(uint i = 0; i < threadCount * 2; i++) {
+    queueRegion(pregen);
+  }
+
+  std::vector<Terrain::generated_chunk_t> generated;
+
+  while(!pregen.pending.empty()) {
+    uint regionsWritten = 0;
+
+    if(Terrain::collect(generated, UINT_MAX) == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      continue;
+    }
+
+    for(const Terrain::generated_chunk_t& chunk : generated) {
+      vec3i region = {WorldStorage::toRegionCoord(chunk.pos.x), WorldStorage::toRegionCoord(chunk.pos.y), WorldStorage::toRegionCoord(chunk.pos.z)};
+      pending_region_t& pending = pregen.pending[region];
+      int x = chunk.pos.x - region.x * WorldStorage::REGION_SIZE;
+      int y = chunk.pos.y - region.y * WorldStorage::REGION_SIZE;
+      int z = chunk.pos.z - region.z * WorldStorage::REGION_SIZE;
+
+      pending.chunks[x + y * WorldStorage::REGION_SIZE + z * WorldStorage::REGION_SIZE * WorldStorage::REGION_SIZE] = chunk.blocks;
+      pregen.chunksGenerated++;
+
+      if(--pending.remaining > 0) {
+        continue;
+      }
+
+      if(!WorldStorage::writeRegion(pregen.directory, region, pending.chunks)) {
+        pregen.regionsFailed++;
+      }
+
+      for(const block_t* blocks : pending.chunks) {
+        pool.release((void*)blocks);
+      }
+
+      pregen.pending.erase(region);
+      queueRegion(pregen);
+      regionsWritten++;
+    }
+
+    generated.clear();
+
+    // columns and lattices would otherwise stay cached for the whole world
+    if(regionsWritten > 0) {
+      trimTerrain(pregen);
+    }
+  }
+
+  Terrain::free();
+
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  uint chunks = pregen.chunksGenerated;
+
+  printf("%u chunks in %.2fs (%.1f chunks/s)\n", chunks, seconds, seconds > 0.0 ? chunks / seconds : 0.0);
+
+  if(pregen.regionsFailed > 0) {
+    fprintf(stderr, "%s: %u regions could not be written\n", __func__, pregen.regionsFailed);
+    return -1;
+  }
+
+  return 0;
+}
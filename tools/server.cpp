@@ -0,0 +1,456 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <limits.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+#include <thread>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#include "common.h"
+#include "net.h"
+#include "terrain.h"
+#include "world_storage.h"
+
+/*
+  headless world server. generates chunks on the terrain pipeline, or loads
+  them from a pregenerated world, and streams them run length encoded to the
+  viewers connected to it. each chunk is encoded once and every client is sent
+  that same buffer. edits from a client are applied to the server's copy and
+  sent to the other clients as deltas. the cache and the terrain pipeline
+  only keep what the clients' areas still need, edited chunks excepted.
+
+  it links the core but not ChunkManager or World: those load one cube around
+  one camera and keep decoded, lit chunks, while the server serves many areas
+  and only ever needs the encoded form. water and block ticks stay on the
+  clients for now
+*/
+
+// ms poll waits for socket activity before checking the terrain workers again
+const int POLL_TIMEOUT = 5;
+
+// encoded chunks kept for clients that come back, a few KB each. the least recently used go first
+const size_t MAX_CACHED_CHUNKS = 16384;
+
+struct client_t {
+  Net::Connection* connection;
+  // requested chunks that aren't encoded yet
+  std::set<vec3i> waiting;
+  // chunks this client holds, it is sent deltas for these
+  std::set<vec3i> sent;
+  // the cube the client keeps loaded, from its last prune. generation outside every client's area is dropped
+  Terrain::area_t area;
+  bool hasArea;
+  bool closed;
+};
+
+struct cached_chunk_t {
+  Net::buffer_ptr encoded;
+  uint64_t lastUsed; // round it was last published or sent
+  bool edited; // edits only live here, so it is never evicted
+};
+
+struct server_t {
+  int listener;
+  std::vector<client_t*> clients;
+
+  // chunks generated or loaded, encoded. a chunk's buffer is replaced when it is edited, never changed
+  std::map<vec3i, cached_chunk_t> chunks;
+  std::set<vec3i> generating;
+  uint64_t round;
+  // a client moved, joined or left, the terrain pipeline is pruned to the new areas
+  bool areasChanged;
+
+  // edits received this round, applied together per chunk
+  std::map<vec3i, std::vector<std::pair<client_t*, Net::message_t>>> edits;
+};
+
+volatile sig_atomic_t running = 1;
+
+void signalHandler(int signum) {
+  running = 0;
+}
+
+inline vec3i readPos(const uint8_t* data) {
+  return {(int)Net::getU32(data), (int)Net::getU32(data + 4), (int)Net::getU32(data + 8)};
+}
+
+inline void writePos(uint8_t* data, vec3i pos) {
+  Net::putU32(data, (uint)pos.x);
+  Net::putU32(data + 4, (uint)pos.y);
+  Net::putU32(data + 8, (uint)pos.z);
+}
+
+void sendChunk(client_t* client, vec3i pos, const Net::buffer_ptr& encoded) {
+  uint8_t head[12];
+  writePos(head, pos);
+
+  client->connection->send(Net::CHUNK, head, sizeof(head), encoded);
+  client->waiting.erase(pos);
+  client->sent.insert(pos);
+}
+
+// a chunk is ready, every client waiting for it gets the same buffer
+void publishChunk(server_t& server, vec3i pos, const block_t* blocks) {
+  std::vector<uint8_t>* encoded = new std::vector<uint8_t>();
+  WorldStorage::encodeChunk(blocks, *encoded);
+
+  Net::buffer_ptr buffer(encoded);
+  cached_chunk_t& cached = server.chunks[pos];
+  cached.encoded = buffer;
+  cached.lastUsed = server.round;
+  cached.edited = false;
+
+  for(client_t* client : server.clients) {
+    if(client->waiting.count(pos) > 0) {
+      sendChunk(client, pos, buffer);
+    }
+  }
+}
+
+void requestChunk(server_t& server, client_t* client, vec3i pos, SlabPool& pool) {
+  std::map<vec3i, cached_chunk_t>::iterator it = server.chunks.find(pos);
+
+  if(it != server.chunks.end()) {
+    it->second.lastUsed = server.round;
+    sendChunk(client, pos, it->second.encoded);
+    return;
+  }
+
+  client->waiting.insert(pos);
+
+  if(server.generating.count(pos) > 0) {
+    return;
+  }
+
+  if(WorldStorage::isOpen()) {
+    block_t* blocks = (block_t*)pool.allocate();
+    bool loaded = WorldStorage::loadChunk(pos.x, pos.y, pos.z, blocks);
+
+    if(loaded) {
+      publishChunk(server, pos, blocks);
+    }
+
+    pool.release(blocks);
+
+    if(loaded) {
+      return;
+    }
+  }
+
+  Terrain::request(pos);
+  server.generating.insert(pos);
+}
+
+void handleMessage(server_t& server, client_t* client, const Net::message_t& message, SlabPool& pool) {
+  switch(message.type) {
+    case Net::REQUEST:
+      if(message.size == 12) {
+        requestChunk(server, client, readPos(message.data), pool);
+      }
+
+      break;
+
+    case Net::PRUNE: {
+      if(message.size != 16) {
+        break;
+      }
+
+      // the client unloads what it moved away from
+      vec3i center = readPos(message.data);
+      int distance = (int)Net::getU32(message.data + 12);
+
+      client->area = {center, distance};
+      client->hasArea = true;
+      server.areasChanged = true;
+
+      for(std::set<vec3i>* positions : {&client->waiting, &client->sent}) {
+        for(std::set<vec3i>::iterator it = positions->begin(); it != positions->end();) {
+          if(abs(it->x - center.x) > distance || abs(it->y - center.y) > distance || abs(it->z - center.z) > distance) {
+            it = positions->erase(it);
+          } else {
+            it++;
+          }
+        }
+      }
+
+      break;
+    }
+
+    case Net::EDIT: {
+      if(message.size != 16) {
+        break;
+      }
+
+      vec3i block = readPos(message.data);
+      vec3i chunkPos = {toChunkCoord(block.x), toChunkCoord(block.y), toChunkCoord(block.z)};
+      uint id = Net::getU32(message.data + 12);
+
+      // other clients would mesh the id, and a client can only edit what it was sent
+      if(!isValidBlock(id) || client->sent.count(chunkPos) == 0) {
+        fprintf(stderr, "%s: rejected edit of %d %d %d to %u\n", __func__, block.x, block.y, block.z, id);
+        break;
+      }
+
+      server.edits[chunkPos].push_back(std::make_pair(client, message));
+      break;
+    }
+
+    default:
+      fprintf(stderr, "%s: unknown message %u\n", __func__, message.type);
+      break;
+  }
+}
+
+// decodes each edited chunk once, applies its edits and forwards them to the other clients holding it
+void applyEdits(server_t& server, SlabPool& pool) {
+  block_t* blocks = (block_t*)pool.allocate();
+
+  for(std::pair<const vec3i, std::vector<std::pair<client_t*, Net::message_t>>>& entry : server.edits) {
+    std::map<vec3i, cached_chunk_t>::iterator it = server.chunks.find(entry.first);
+
+    if(it == server.chunks.end() || !WorldStorage::decodeChunk(it->second.encoded->data(), it->second.encoded->size(), blocks)) {
+      continue;
+    }
+
+    for(const std::pair<client_t*, Net::message_t>& edit : entry.second) {
+      vec3i block = readPos(edit.second.data);
+      blocks[blockIndex(toLocalCoord(block.x), toLocalCoord(block.y), toLocalCoord(block.z))] = (block_t)Net::getU32(edit.second.data + 12);
+
+      for(client_t* client : server.clients) {
+        if(client != edit.first && client->sent.count(entry.first) > 0) {
+          client->connection->send(Net::DELTA, edit.second.data, edit.second.size);
+        }
+      }
+    }
+
+    // clients still holding the old buffer in their send queues keep it alive
+    std::vector<uint8_t>* encoded = new std::vector<uint8_t>();
+    WorldStorage::encodeChunk(blocks, *encoded);
+    it->second.encoded = Net::buffer_ptr(encoded);
+    it->second.lastUsed = server.round;
+    it->second.edited = true;
+  }
+
+  pool.release(blocks);
+  server.edits.clear();
+}
+
+// drops generation no client wants anymore, waits until every client told where it is
+void pruneTerrain(server_t& server) {
+  std::vector<Terrain::area_t> areas;
+
+  for(client_t* client : server.clients) {
+    if(!client->hasArea) {
+      return;
+    }
+
+    areas.push_back(client->area);
+  }
+
+  Terrain::prune(areas);
+
+  // pruned chunks never arrive, a later request has to queue them again
+  for(std::set<vec3i>::iterator it = server.generating.begin(); it != server.generating.end();) {
+    bool wanted = false;
+
+    for(const Terrain::area_t& area : areas) {
+      if(abs(it->x - area.center.x) <= area.distance && abs(it->y - area.center.y) <= area.distance && abs(it->z - area.center.z) <= area.distance) {
+        wanted = true;
+        break;
+      }
+    }
+
+    if(wanted) {
+      it++;
+    } else {
+      it = server.generating.erase(it);
+    }
+  }
+}
+
+// evicts the least recently used chunks no client holds or waits for until the cache is back under its cap
+void evictChunks(server_t& server) {
+  if(server.chunks.size() <= MAX_CACHED_CHUNKS) {
+    return;
+  }
+
+  std::set<vec3i> held;
+
+  for(client_t* client : server.clients) {
+    held.insert(client->sent.begin(), client->sent.end());
+    held.insert(client->waiting.begin(), client->waiting.end());
+  }
+
+  std::vector<std::pair<uint64_t, vec3i>> candidates;
+
+  for(const std::pair<const vec3i, cached_chunk_t>& entry : server.chunks) {
+    if(!entry.second.edited && held.count(entry.first) == 0) {
+      candidates.push_back(std::make_pair(entry.second.lastUsed, entry.first));
+    }
+  }
+
+  // an eighth below the cap, so a full cache isn't sorted again every round
+  size_t excess = server.chunks.size() - MAX_CACHED_CHUNKS + MAX_CACHED_CHUNKS / 8;
+  size_t count = MIN(excess, candidates.size());
+
+  std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end());
+
+  for(size_t i = 0; i < count; i++) {
+    server.chunks.erase(candidates[i].second);
+  }
+}
+
+int main(int argc, char** argv) {
+#ifdef _WIN32
+  fprintf(stderr, "%s: the server needs unix sockets and poll, windows is not supported yet\n", __func__);
+  return -1;
+#else
+
+  if(argc != 3 && argc != 4) {
+    printf("usage: %s <address> <seed> [world directory]\n", argv[0]);
+    printf("  address is a unix socket path or tcp:<port> for 127.0.0.1\n");
+    return -1;
+  }
+
+  const char* address = argv[1];
+  uint seed = (uint)strtoul(argv[2], NULL, 10);
+
+  // a pregenerated world brings its own seed
+  if(argc == 4) {
+    if(!WorldStorage::open(argv[3], &seed)) {
+      fprintf(stderr, "%s: unable to open world %s\n", __func__, argv[3]);
+      return -1;
+    }
+
+    printf("world: %s\n", argv[3]);
+  }
+
+  Terrain::setSeed(seed);
+
+  server_t server;
+  server.round = 0;
+  server.areasChanged = false;
+  server.listener = Net::listen(address);
+
+  if(server.listener == -1) {
+    return -1;
+  }
+
+  signal(SIGINT, signalHandler);
+  signal(SIGTERM, signalHandler);
+  signal(SIGPIPE, SIG_IGN);
+
+  SlabPool pool(CHUNK_SIZE_CUBED * sizeof(block_t), 64, MemoryTracker::CHUNK_STORAGE);
+  Terrain::init(MAX(std::thread::hardware_concurrency(), 1u), &pool);
+
+  printf("serving seed %u on %s\n", seed, address);
+
+  std::vector<pollfd> handles;
+  std::vector<Terrain::generated_chunk_t> generated;
+  Net::message_t message;
+
+  while(running) {
+    server.round++;
+    handles.clear();
+    handles.push_back({server.listener, POLLIN, 0});
+
+    for(client_t* client : server.clients) {
+      short events = POLLIN | (client->connection->hasPendingSend() ? POLLOUT : 0);
+      handles.push_back({client->connection->getHandle(), events, 0});
+    }
+
+    poll(handles.data(), handles.size(), POLL_TIMEOUT);
+
+    if(handles[0].revents & POLLIN) {
+      int handle;
+
+      while((handle = Net::accept(server.listener)) != -1) {
+        client_t* client = new client_t();
+        client->connection = new Net::Connection(handle);
+        client->hasArea = false;
+        client->closed = false;
+
+        uint8_t hello[8];
+        Net::putU32(hello, Net::PROTOCOL_VERSION);
+        Net::putU32(hello + 4, seed);
+        client->connection->send(Net::HELLO, hello, sizeof(hello));
+
+        server.clients.push_back(client);
+        printf("client connected, %u total\n", (uint)server.clients.size());
+      }
+    }
+
+    // messages point into the inbox, edits are applied before the next receive
+    for(uint i = 0; i < server.clients.size(); i++) {
+      client_t* client = server.clients[i];
+
+      if(!client->connection->receive()) {
+        client->closed = true;
+        continue;
+      }
+
+      while(client->connection->next(&message)) {
+        handleMessage(server, client, message, pool);
+      }
+    }
+
+    applyEdits(server, pool);
+
+    if(Terrain::collect(generated, UINT_MAX) > 0) {
+      for(const Terrain::generated_chunk_t& chunk : generated) {
+        server.generating.erase(chunk.pos);
+        publishChunk(server, chunk.pos, chunk.blocks);
+        pool.release(chunk.blocks);
+      }
+
+      generated.clear();
+    }
+
+    for(std::vector<client_t*>::iterator it = server.clients.begin(); it != server.clients.end();) {
+      client_t* client = *it;
+
+      if(!client->closed && client->connection->flush()) {
+        it++;
+        continue;
+      }
+
+      delete client->connection;
+      delete client;
+      it = server.clients.erase(it);
+      server.areasChanged = true;
+      printf("client disconnected, %u left\n", (uint)server.clients.size());
+    }
+
+    if(server.areasChanged) {
+      pruneTerrain(server);
+      server.areasChanged = false;
+    }
+
+    evictChunks(server);
+  }
+
+  printf("shutting down, %u chunks cached\n", (uint)server.chunks.size());
+
+  for(client_t* client : server.clients) {
+    delete client->connection;
+    delete client;
+  }
+
+  Terrain::free();
+  Net::close(server.listener);
+
+  if(strncmp(address, "tcp:", 4) != 0) {
+    unlink(address);
+  }
+
+  return 0;
+#endif
+}